@@ -34,7 +34,23 @@ f(n) is Θ (g(n)) if it is Ω (g(n)) and O(g(n))
 
 #include <iostream>
 #include <vector>
+#include <deque>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <algorithm> // For sort function
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <numeric>
+#include <random>
+#include "complexity_estimator.h"
+#include "Sorting/radix_sort.h"
 using namespace std;
 
 // Sorting function with O(n^2) time complexity (Bubble Sort)
@@ -57,33 +73,313 @@ void Sort(int x[], int n) {
 
 
 // Example: Read, Sort, and Write Algorithm
-void Read_sort_write(int n, int m) {
-    vector<int> x(n); // Declare an array of size 'n'
+/*
+Read_sort_write reads m arrays of n integers, sorts each one and writes it.
+Reading, sorting and writing are three stages running on their own
+threads, connected by bounded queues: while array k is being sorted,
+array k + 1 is being parsed and array k - 1 written. The total time is
+then about m times the slowest stage instead of m times the sum of all
+three, and the bounded queues keep at most a few arrays in memory.
+
+- Reading: the input is mapped with mmap when it is a regular file and
+  read in large blocks with read(2) otherwise, and parsed with a small
+  hand-written integer parser instead of cin >> (no locale, no
+  formatting state, no virtual calls per character).
+- Sorting: any function void(int[], int) can be plugged in; Sort (bubble
+  sort, O(n^2)), sortNLogN (std::sort) and radixSortInts (O(n)) are provided.
+- Writing: numbers are formatted into a large buffer that is written
+  with write(2) when full, instead of one cout << per number.
+
+Output format: "Sorted array k: x1 x2 ... xn \n" for every array.
+*/
+typedef void (*BatchSorter)(int data[], int n);
+
+void sortNLogN(int data[], int n) {
+    sort(data, data + n);
+}
+
+// LSD radix sort on 8-bit digits (lsdRadixSort from Sorting/radix_sort.h);
+// signedKey flips the sign bit so negative numbers come first
+void radixSortInts(int data[], int n) {
+    vector<int> buffer(n);
+    lsdRadixSort(data, buffer.data(), n, signedKey);
+}
+
+// Queue between two stages: push blocks while it is full, pop while it is empty
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity) {}
+
+    // Returns false if the queue was closed (the consumer gave up)
+    bool push(T item) {
+        unique_lock<mutex> lock(m);
+        notFull.wait(lock, [this] { return items.size() < capacity || closed; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(move(item));
+        notEmpty.notify_one();
+        return true;
+    }
 
-    for (int array = 1; array <= m; array++) { // Loop 'm' times
-        // Read the array
-        cout << "Enter " << n << " elements for array " << array << ": ";
-        for (int i = 0; i < n; i++) {
-            cin >> x[i];
+    // Returns false once the queue is closed and empty
+    bool pop(T& item) {
+        unique_lock<mutex> lock(m);
+        notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+        if (items.empty()) {
+            return false;
         }
+        item = move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    // No more items: wakes up every waiting push and pop
+    void close() {
+        lock_guard<mutex> lock(m);
+        closed = true;
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
 
-        // Sort the array
-        Sort(x.data(), n);
+private:
+    size_t capacity;
+    deque<T> items;
+    bool closed = false;
+    mutex m;
+    condition_variable notEmpty, notFull;
+};
+
+// Buffered integer parser over a file descriptor (mmap for regular files, read(2) otherwise)
+class IntParser {
+public:
+    explicit IntParser(int fd) : fd(fd) {
+        // The input starts at the current offset of fd (part of it may have been read already);
+        // mappings start on a page boundary, so the bytes before the offset are skipped
+        struct stat info;
+        off_t offset = lseek(fd, 0, SEEK_CUR);
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && offset >= 0 && offset < info.st_size) {
+            off_t start = offset - offset % sysconf(_SC_PAGESIZE);
+            size_t size = info.st_size - start;
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, start);
+            if (mapped != MAP_FAILED) {
+                madvise(mapped, size, MADV_SEQUENTIAL);
+                mapping = static_cast<const char*>(mapped);
+                mappingSize = size;
+                pos = mapping + (offset - start);
+                end = mapping + mappingSize;
+                return;
+            }
+        }
+        buffer.resize(1 << 20);
+    }
 
-        // Print the sorted array
-        cout << "Sorted array " << array << ": ";
-        for (int i = 0; i < n; i++) {
-            cout << x[i] << " ";
+    ~IntParser() {
+        if (mapping) {
+            munmap(const_cast<char*>(mapping), mappingSize);
+        }
+    }
+
+    // Reads the next integer; returns false at the end of the input
+    bool next(int& value) {
+        int c = skipSpaces();
+        if (c < 0) {
+            return false;
+        }
+        bool negative = c == '-';
+        if (negative || c == '+') {
+            pos++;
+            c = peek();
+        }
+        if (c < '0' || c > '9') {
+            throw runtime_error("Read_sort_write: expected an integer in the input");
+        }
+        long long result = 0;
+        while (c >= '0' && c <= '9') {
+            result = result * 10 + (c - '0');
+            if (result > 2147483648LL) {
+                throw out_of_range("Read_sort_write: integer out of range in the input");
+            }
+            pos++;
+            c = peek();
+        }
+        if (!negative && result > 2147483647LL) {
+            throw out_of_range("Read_sort_write: integer out of range in the input");
+        }
+        value = static_cast<int>(negative ? -result : result);
+        return true;
+    }
+
+private:
+    int fd;
+    const char* mapping = nullptr;
+    size_t mappingSize = 0;
+    vector<char> buffer;
+    const char* pos = nullptr;
+    const char* end = nullptr;
+
+    // Next character without consuming it, -1 at the end of the input
+    int peek() {
+        if (pos == end && !refill()) {
+            return -1;
+        }
+        return static_cast<unsigned char>(*pos);
+    }
+
+    int skipSpaces() {
+        int c = peek();
+        while (c == ' ' || c == '\n' || c == '\t' || c == '\r') {
+            pos++;
+            c = peek();
+        }
+        return c;
+    }
+
+    bool refill() {
+        if (mapping) {
+            return false;
+        }
+        ssize_t got;
+        do {
+            got = read(fd, buffer.data(), buffer.size());
+        } while (got < 0 && errno == EINTR);
+        if (got < 0) {
+            throw runtime_error("Read_sort_write: read failed");
+        }
+        pos = buffer.data();
+        end = pos + got;
+        return got > 0;
+    }
+};
+
+// Formats integers into a large buffer that is written to fd with write(2) when full
+class IntWriter {
+public:
+    explicit IntWriter(int fd) : fd(fd), buffer(1 << 20) {}
+
+    void write(const char* text, size_t length) {
+        if (used + length > buffer.size()) {
+            flush();
+        }
+        memcpy(buffer.data() + used, text, length);
+        used += length;
+    }
+
+    void writeInt(int value) {
+        char digits[12];
+        char* p = digits + sizeof(digits);
+        unsigned magnitude = value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value);
+        do {
+            *--p = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (value < 0) {
+            *--p = '-';
+        }
+        write(p, digits + sizeof(digits) - p);
+    }
+
+    void flush() {
+        size_t done = 0;
+        while (done < used) {
+            ssize_t written = ::write(fd, buffer.data() + done, used - done);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written < 0) {
+                throw runtime_error("Read_sort_write: write failed");
+            }
+            done += written;
+        }
+        used = 0;
+    }
+
+private:
+    int fd;
+    vector<char> buffer;
+    size_t used = 0;
+};
+
+void Read_sort_write(int n, int m, BatchSorter sorter = sortNLogN, int inputFd = 0, int outputFd = 1) {
+    const size_t queueCapacity = 4; // arrays waiting between two stages
+    BoundedQueue<vector<int>> parsed(queueCapacity), sorted(queueCapacity);
+    exception_ptr readError, sortError;
+
+    // Stage 1: read and parse m arrays of n integers
+    thread reader([&] {
+        try {
+            IntParser parser(inputFd);
+            for (int array = 1; array <= m; array++) {
+                vector<int> x(n);
+                for (int i = 0; i < n; i++) {
+                    if (!parser.next(x[i])) {
+                        throw runtime_error("Read_sort_write: input ended in array " + to_string(array));
+                    }
+                }
+                if (!parsed.push(move(x))) {
+                    break;
+                }
+            }
+        } catch (...) {
+            readError = current_exception();
+        }
+        parsed.close();
+    });
+
+    // Stage 2: sort every array
+    thread sorterThread([&] {
+        try {
+            vector<int> x;
+            while (parsed.pop(x)) {
+                sorter(x.data(), n);
+                if (!sorted.push(move(x))) {
+                    break;
+                }
+            }
+        } catch (...) {
+            sortError = current_exception();
+        }
+        parsed.close(); // stops the reader if sorting failed
+        sorted.close();
+    });
+
+    // Stage 3 (this thread): format and write
+    exception_ptr writeError;
+    try {
+        IntWriter writer(outputFd);
+        vector<int> x;
+        for (int array = 1; sorted.pop(x); array++) {
+            string header = "Sorted array " + to_string(array) + ": ";
+            writer.write(header.data(), header.size());
+            for (int i = 0; i < n; i++) {
+                writer.writeInt(x[i]);
+                writer.write(" ", 1);
+            }
+            writer.write("\n", 1);
+        }
+        writer.flush();
+    } catch (...) {
+        writeError = current_exception();
+        sorted.close(); // stops the other stages
+        parsed.close();
+    }
+
+    reader.join();
+    sorterThread.join();
+    for (exception_ptr error : {readError, sortError, writeError}) {
+        if (error) {
+            rethrow_exception(error);
         }
-        cout << endl;
     }
     // Time Complexity:
     // T(readArray) = O(n)
-    // T(sortArray) = O(n^2)
+    // T(sortArray) = O(n log n) with sortNLogN, O(n) with radixSortInts, O(n^2) with Sort
     // T(printArray) = O(n)
-    // T(read + sort + print) = O(n + n^2 + n) = O(n^2)
-    // The above three algorithms are executed 'm' times
-    // Therefore, the overall time complexity of Read_sort_write is O(m * n^2)
+    // The three stages overlap, so m arrays take about m * max(T(read), T(sort), T(print))
+    // instead of m * (T(read) + T(sort) + T(print)); both are O(m * n log n) with sortNLogN
+    // Space Complexity: O(n) per array in flight, at most 2 * queueCapacity + 3 arrays
 }
 
 
@@ -166,7 +462,71 @@ void factorialTimeExample(int n, vector<int>& permutation, vector<bool>& used) {
     }
 }
 
-int main() {
+// Measures the complexity of the examples with complexity_estimator.h
+void estimateExamples() {
+    // Random input of size n, built outside the timed part
+    auto randomArray = [](long long n) {
+        vector<int> x(n);
+        mt19937 rng(static_cast<unsigned>(n));
+        for (int& v : x) v = static_cast<int>(rng());
+        return x;
+    };
+    ComplexityOptions quadratic;
+    quadratic.maxN = 1 << 13;
+    cout << "Sort (bubble sort): " << describe(estimateComplexity(randomArray,
+        [](vector<int>& x) { Sort(x.data(), static_cast<int>(x.size())); }, quadratic)) << endl;
+    // Arrays that fit in the cache: beyond it every element costs more, and the
+    // fit would show the memory hierarchy instead of the algorithm
+    ComplexityOptions inCache;
+    inCache.maxN = 1 << 14;
+    cout << "sortNLogN: " << describe(estimateComplexity(randomArray,
+        [](vector<int>& x) { sortNLogN(x.data(), static_cast<int>(x.size())); }, inCache)) << endl;
+    cout << "radixSortInts: " << describe(estimateComplexity(randomArray,
+        [](vector<int>& x) { radixSortInts(x.data(), static_cast<int>(x.size())); }, inCache)) << endl;
+
+    // 1000 binary searches per run, so one run is well above the clock resolution
+    auto sortedArray = [](long long n) {
+        vector<int> x(n);
+        iota(x.begin(), x.end(), 0);
+        return x;
+    };
+    ComplexityOptions logarithmic;
+    logarithmic.maxN = 1 << 18;
+    cout << "binary search: " << describe(estimateComplexity(sortedArray, [](vector<int>& x) {
+        for (int i = 0; i < 1000; i++) {
+            bool found = binary_search(x.begin(), x.end(), static_cast<int>(i * 7919 % x.size()));
+            doNotOptimize(found);
+        }
+    }, logarithmic)) << endl;
+
+    // Fibonacci-style recursion makes about 1.618^n calls: O(2^n), though not Θ(2^n)
+    ComplexityOptions exponential;
+    exponential.minN = 10;
+    exponential.maxN = 32;
+    exponential.growth = 1; // n = 10, 11, 12, ...
+    cout << "exponentialTimeExample: " << describe(estimateRunComplexity([](long long n) {
+        int result = exponentialTimeExample(static_cast<int>(n));
+        doNotOptimize(result);
+    }, exponential)) << endl;
+}
+
+int main(int argc, char* argv[]) {
+    // ./complexity --read-sort-write n m < input: runs Read_sort_write on stdin
+    if (argc == 4 && string(argv[1]) == "--read-sort-write") {
+        try {
+            Read_sort_write(stoi(argv[2]), stoi(argv[3]));
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+    // ./complexity --estimate: measures the complexity of the examples
+    if (argc == 2 && string(argv[1]) == "--estimate") {
+        estimateExamples();
+        return 0;
+    }
+
     // O(1) Example
     constantTimeExample();
 
@@ -0,0 +1,139 @@
+// argsort.h
+#ifndef ARGSORT_H
+#define ARGSORT_H
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#include "generic_sorts.h"
+
+/*
+Argsort: the permutation that sorts a column, instead of the sorted column.
+For a table stored as parallel columns, one column is argsorted and the
+permutation is then applied to every column:
+
+    std::vector<uint32_t> order = radixArgsort(price, n);
+    applyPermutation(order.data(), n, price, quantity, timestamp);
+
+order[i] is the row that comes i-th. Every argsort here is stable: rows with
+equal keys keep their original order, so sorting by several columns can be
+done least significant column first.
+
+Keys are copied next to their row index and the (key, index) pairs are
+sorted, so comparisons read adjacent memory instead of following indices
+into the column.
+*/
+
+template <class T>
+struct KeyIndex {
+    T key;
+    uint32_t index;
+};
+
+template <class T>
+std::vector<KeyIndex<T>> keyIndexPairs(const T keys[], uint32_t n) {
+    std::vector<KeyIndex<T>> pairs(n);
+    for (uint32_t i = 0; i < n; i++) {
+        pairs[i] = {keys[i], i};
+    }
+    return pairs;
+}
+
+template <class T>
+std::vector<uint32_t> pairIndices(const std::vector<KeyIndex<T>>& pairs) {
+    std::vector<uint32_t> order(pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        order[i] = pairs[i].index;
+    }
+    return order;
+}
+
+// Merge sort (stable by itself)
+template <class T, class Compare = std::less<>>
+std::vector<uint32_t> mergeArgsort(const T keys[], uint32_t n, Compare comp = Compare()) {
+    std::vector<KeyIndex<T>> pairs = keyIndexPairs(keys, n);
+    mergeSort(pairs.begin(), pairs.end(), [&comp](const KeyIndex<T>& a, const KeyIndex<T>& b) {
+        return comp(a.key, b.key);
+    });
+    return pairIndices(pairs);
+}
+
+// Introsort; equal keys are ordered by row index, which makes it stable
+template <class T, class Compare = std::less<>>
+std::vector<uint32_t> quickArgsort(const T keys[], uint32_t n, Compare comp = Compare()) {
+    std::vector<KeyIndex<T>> pairs = keyIndexPairs(keys, n);
+    quickSort(pairs.begin(), pairs.end(), [&comp](const KeyIndex<T>& a, const KeyIndex<T>& b) {
+        if (comp(a.key, b.key)) return true;
+        if (comp(b.key, a.key)) return false;
+        return a.index < b.index;
+    });
+    return pairIndices(pairs);
+}
+
+// LSD radix sort on integer keys of any width, float or double (stable by itself)
+template <class Int>
+std::vector<uint32_t> radixArgsort(const Int keys[], uint32_t n) {
+    using Key = decltype(orderedKey(keys[0]));
+    std::vector<KeyIndex<Key>> pairs(n), buffer(n);
+    for (uint32_t i = 0; i < n; i++) {
+        pairs[i] = {orderedKey(keys[i]), i};
+    }
+    lsdRadixSort(pairs.data(), buffer.data(), n, [](const KeyIndex<Key>& e) { return e.key; });
+    return pairIndices(pairs);
+}
+
+/*
+Applies a permutation to any number of columns (of any element types):
+afterwards column[i] is the old column[order[i]] for every column.
+
+The gathers are cache-blocked: order is walked in blocks of
+permutationBlock indices and each block is applied to every column before
+moving on, so a block of the permutation is read from memory once and then
+stays in L1 for all columns. The random reads are prefetched a few
+iterations ahead. Every column is gathered into a scratch array, which is
+moved back at the end.
+*/
+const uint32_t permutationBlock = 4096;
+const uint32_t permutationPrefetch = 16;
+
+template <class T>
+void gatherBlock(const uint32_t order[], uint32_t begin, uint32_t end, uint32_t n, const T column[], T out[]) {
+    for (uint32_t i = begin; i < end; i++) {
+#if defined(__GNUC__)
+        if (n - i > permutationPrefetch) { // i + permutationPrefetch < n, without wrapping
+            __builtin_prefetch(&column[order[i + permutationPrefetch]]);
+        }
+#endif
+        out[i] = column[order[i]];
+    }
+}
+
+template <class... T>
+void applyPermutation(const uint32_t order[], uint32_t n, T*... columns) {
+    std::tuple<std::vector<T>...> scratch{std::vector<T>(n)...};
+    // 64-bit block bounds: begin + permutationBlock wraps when n is close to UINT32_MAX
+    for (uint64_t begin = 0; begin < n; begin += permutationBlock) {
+        uint32_t end = static_cast<uint32_t>(std::min<uint64_t>(n, begin + permutationBlock));
+        std::apply([&](std::vector<T>&... out) {
+            (gatherBlock(order, static_cast<uint32_t>(begin), end, n, columns, out.data()), ...);
+        }, scratch);
+    }
+    std::apply([&](std::vector<T>&... out) {
+        (std::move(out.begin(), out.end(), columns), ...);
+    }, scratch);
+}
+
+/*
+Time Complexity:
+- mergeArgsort, quickArgsort: O(n log n)
+- radixArgsort: O(n * w / 8) for w-bit keys, passes on constant bytes skipped
+- applyPermutation: O(n) per column
+
+Space Complexity: the (key, index) pairs and the returned permutation;
+applyPermutation needs a scratch copy of every column.
+
+Notes:
+n must fit in 32 bits (uint32_t indices keep the pairs small).
+*/
+
+#endif
@@ -1,5 +1,8 @@
 #include <iostream>
 #include <algorithm>
+#include <vector>
+#include "sorts.h"
+#include "parallel.h"
 using namespace std;
 
 // shell sort
@@ -9,14 +12,14 @@ void shellSort(int data[], int n) {
     for (int gap = n / 2; gap > 0; gap /= 2) {
         // Perform a gapped insertion sort for this gap size
         for (int i = gap; i < n; i++) {
-            int temp = data[i];
+            int temp = SORT_MOVE(data[i]);
             int j;
             // Shift earlier gap-sorted elements up until the correct location for data[i] is found
-            for (j = i; j >= gap && data[j - gap] > temp; j -= gap) {
-                data[j] = data[j - gap];
+            for (j = i; j >= gap && SORT_CMP(data[j - gap] > temp); j -= gap) {
+                SORT_MOVE(data[j] = data[j - gap]);
             }
             // Put temp (the original data[i]) in its correct location
-            data[j] = temp;
+            SORT_MOVE(data[j] = temp);
         }
     }
 }
@@ -34,7 +37,7 @@ significantly affects the performance of the algorithm.
 */
 /////////////////////////////////////////////////////////////////
 // merge sort
-void merge(int data[], int left, int mid, int right) {
+static void merge(int data[], int left, int mid, int right) {
     int n1 = mid - left + 1;
     int n2 = right - mid;
 
@@ -44,18 +47,18 @@ void merge(int data[], int left, int mid, int right) {
 
     // Copy data to temporary arrays
     for (int i = 0; i < n1; i++)
-        leftArray[i] = data[left + i];
+        SORT_MOVE(leftArray[i] = data[left + i]);
     for (int j = 0; j < n2; j++)
-        rightArray[j] = data[mid + 1 + j];
+        SORT_MOVE(rightArray[j] = data[mid + 1 + j]);
 
     // Merge the temporary arrays back into data[left..right]
     int i = 0, j = 0, k = left;
     while (i < n1 && j < n2) {
-        if (leftArray[i] <= rightArray[j]) {
-            data[k] = leftArray[i];
+        if (SORT_CMP(leftArray[i] <= rightArray[j])) {
+            SORT_MOVE(data[k] = leftArray[i]);
             i++;
         } else {
-            data[k] = rightArray[j];
+            SORT_MOVE(data[k] = rightArray[j]);
             j++;
         }
         k++;
@@ -63,14 +66,14 @@ void merge(int data[], int left, int mid, int right) {
 
     // Copy the remaining elements of leftArray, if any
     while (i < n1) {
-        data[k] = leftArray[i];
+        SORT_MOVE(data[k] = leftArray[i]);
         i++;
         k++;
     }
 
     // Copy the remaining elements of rightArray, if any
     while (j < n2) {
-        data[k] = rightArray[j];
+        SORT_MOVE(data[k] = rightArray[j]);
         j++;
         k++;
     }
@@ -109,41 +112,1009 @@ This is represented by the condition `if (left < right)` in the `mergeSort` func
 When `left` is not less than `right`, the recursion stops.
 */
 /////////////////////////////////////////////////////////////////
-// quick sort
-int partition(int data[], int left, int right) {
-    int pivot = data[left]; // Choose the first element as the pivot
-    int i = left; // Index for elements smaller than the pivot
+// parallel merge sort
+/*
+mergeSort above creates two new arrays in every call of merge().
+This version allocates a single scratch buffer of n elements up front and
+ping-pongs between it and data: each level of the recursion merges from
+one array into the other, so nothing is copied back and nothing is
+allocated after the start.
+
+Parallel phases:
+1. data is split into one slice per thread and every thread sorts its slice.
+2. Neighbouring runs are merged in rounds (p runs -> p/2 -> ... -> 1).
+   Every thread writes an equal share of the output of a round; the
+   start of its share inside the two runs is found by binary search
+   (merge path), so all threads stay busy even in the last round where
+   only two runs are left.
+Ties are always taken from the left run first, so the sort is stable.
+*/
+const int mergeLeafSize = 32;
 
-    for (int j = left + 1; j <= right; j++) {
-        if (data[j] < pivot) {
-            i++; // Move the index for smaller elements
-            swap(data[i], data[j]); // Swap the current element    with the element at i
+// Number of elements taken from a[] among the first k outputs of merging a[0..la) and b[0..lb)
+static long long mergePathSplit(const int a[], long long la, const int b[], long long lb, long long k) {
+    long long lo = max(0LL, k - lb);
+    long long hi = min(k, la);
+    while (lo < hi) {
+        long long i = lo + (hi - lo) / 2;
+        long long j = k - i;
+        // a[i] must come before b[j - 1] (ties go to a): take more from a
+        if (SORT_CMP(a[i] <= b[j - 1])) {
+            lo = i + 1;
+        } else {
+            hi = i;
         }
     }
-    // Swap the pivot element into its correct position
-    swap(data[i], data[left]); 
-    return i; // Return the partition index
+    return lo;
 }
 
-void quickSort(int data[], int left, int right) {
-    if (left < right) {
-        int pi = partition(data, left, right); // Partitioning index
+// Merges a[0..la) and b[0..lb) into out[], ties taken from a
+static void mergeInto(const int a[], long long la, const int b[], long long lb, int out[]) {
+    long long i = 0, j = 0, k = 0;
+    while (i < la && j < lb) {
+        if (SORT_CMP(b[j] < a[i])) {
+            SORT_MOVE(out[k++] = b[j++]);
+        } else {
+            SORT_MOVE(out[k++] = a[i++]);
+        }
+    }
+    while (i < la) SORT_MOVE(out[k++] = a[i++]);
+    while (j < lb) SORT_MOVE(out[k++] = b[j++]);
+}
+
+// Sorts [left, right) into dst; src and dst hold the same elements there on entry
+static void splitMerge(int src[], int dst[], long long left, long long right) {
+    if (right - left <= mergeLeafSize) {
+        networkSort(dst + left, static_cast<int>(right - left));
+        return;
+    }
+    long long mid = left + (right - left) / 2;
+    // Sort both halves into src, then merge them into dst
+    splitMerge(dst, src, left, mid);
+    splitMerge(dst, src, mid, right);
+    mergeInto(src + left, mid - left, src + mid, right - mid, dst + left);
+}
+
+void parallelMergeSort(int data[], int n, int threads) {
+    if (n < 2) {
+        return;
+    }
+    vector<int> scratch(data, data + n); // the only allocation
+    int* buffer = scratch.data();
+
+    // Phase 1: every thread sorts its own slice in place
+    int parts = sortThreadCount(threads);
+    parts = static_cast<int>(min<long long>(parts, max(1, n / mergeLeafSize)));
+    vector<long long> runs(parts + 1);
+    for (int t = 0; t <= parts; t++) {
+        runs[t] = sliceBegin(n, parts, t);
+    }
+    parallelFor(parts, [&](int t) {
+        splitMerge(buffer, data, runs[t], runs[t + 1]);
+    });
+
+    // Phase 2: merge neighbouring runs, ping-ponging between data and buffer
+    int* src = data;
+    int* dst = buffer;
+    while (runs.size() > 2) {
+        int runCount = static_cast<int>(runs.size()) - 1;
+        parallelFor(parts, [&](int t) {
+            long long outBegin = sliceBegin(n, parts, t);
+            long long outEnd = sliceBegin(n, parts, t + 1);
+            for (int r = 0; r < runCount; r += 2) {
+                long long left = runs[r];
+                long long mid = runs[r + 1];
+                long long right = r + 2 <= runCount ? runs[r + 2] : mid;
+                long long from = max(outBegin, left);
+                long long to = min(outEnd, right);
+                if (from >= to) {
+                    continue;
+                }
+                // Part [from, to) of the merged pair (a lone last run is just copied)
+                long long la = mid - left, lb = right - mid;
+                long long i0 = mergePathSplit(src + left, la, src + mid, lb, from - left);
+                long long i1 = mergePathSplit(src + left, la, src + mid, lb, to - left);
+                long long j0 = (from - left) - i0, j1 = (to - left) - i1;
+                mergeInto(src + left + i0, i1 - i0, src + mid + j0, j1 - j0, dst + from);
+            }
+        });
+        vector<long long> merged;
+        for (int r = 0; r < runCount; r += 2) {
+            merged.push_back(runs[r]);
+        }
+        merged.push_back(n);
+        runs.swap(merged);
+        swap(src, dst);
+    }
+
+    // The sorted result ends up in buffer after an odd number of rounds
+    if (src != data) {
+        parallelFor(parts, [&](int t) {
+            long long from = sliceBegin(n, parts, t), to = sliceBegin(n, parts, t + 1);
+            copy(src + from, src + to, data + from);
+        });
+    }
+}
+
+/*
+Time Complexity: O(n log n) in every case, O(n log n / p + n log p) with p threads
+
+Space Complexity: one buffer of n elements (mergeSort allocates O(n) in
+every merge and keeps it on the stack).
+
+Notes:
+- Ranges of up to 32 elements are finished with networkSort (a SIMD
+  sorting network, sorting_network.cpp), which is faster than recursing
+  down to single elements.
+- parallelMergeSort(data, n, 1) is the single-threaded buffer-reusing version.
+*/
+/////////////////////////////////////////////////////////////////
+// adaptive natural merge sort (TimSort)
+/*
+mergeSort splits at the midpoint whatever the input looks like. Real inputs
+are often concatenations of sorted (or reverse-sorted) runs, and timSort
+merges those runs instead:
+1. Runs are found left to right. A strictly descending run is reversed in
+   place (strictly, so equal keys keep their order); runs shorter than
+   minRun (32..64) are extended with binary insertion sort.
+2. Every run is pushed on a stack of pending runs, and the top runs are
+   merged until the lengths satisfy, from the top down,
+       len[i - 2] > len[i - 1] + len[i]  and  len[i - 1] > len[i]
+   so the lengths grow at least like the Fibonacci numbers: merges stay
+   balanced and the stack holds O(log n) runs.
+3. Before a merge, the part of the left run that is already smaller than
+   the right run and the part of the right run that is already larger
+   than the left run are found by galloping and left in place. Only the
+   shorter of the two remaining runs is copied to the buffer.
+4. While merging, once one run wins minGallop times in a row, the merge
+   switches to galloping: the next element of the other run is located by
+   exponential search and the whole block before it is moved at once.
+   minGallop goes down while galloping pays off and up when it does not.
+*/
+const int timSortMinMerge = 64; // below this the whole array is one binary insertion sort
+const int timSortMinGallop = 7;
+
+// Binary insertion sort of data[lo..hi), where data[lo..start) is already sorted
+static void binaryInsertionSort(int data[], int lo, int hi, int start) {
+    for (int i = start; i < hi; i++) {
+        int pivot = SORT_MOVE(data[i]);
+        // First position whose element is greater than pivot: equal keys stay in front (stable)
+        int left = lo, right = i;
+        while (left < right) {
+            int mid = left + (right - left) / 2;
+            if (SORT_CMP(pivot < data[mid])) {
+                right = mid;
+            } else {
+                left = mid + 1;
+            }
+        }
+        for (int j = i; j > left; j--) {
+            SORT_MOVE(data[j] = data[j - 1]);
+        }
+        SORT_MOVE(data[left] = pivot);
+    }
+}
+
+// Length of the run starting at data[lo]; a descending run is reversed so it ascends
+static int countRunAndMakeAscending(int data[], int lo, int hi) {
+    int runHi = lo + 1;
+    if (runHi == hi) {
+        return 1;
+    }
+    if (SORT_CMP(data[runHi] < data[lo])) {
+        // Strictly descending: reversing it cannot reorder equal keys
+        runHi++;
+        while (runHi < hi && SORT_CMP(data[runHi] < data[runHi - 1])) {
+            runHi++;
+        }
+        for (int i = lo, j = runHi - 1; i < j; i++, j--) {
+            SORT_SWAP(data[i], data[j]);
+        }
+    } else {
+        runHi++;
+        while (runHi < hi && !SORT_CMP(data[runHi] < data[runHi - 1])) {
+            runHi++;
+        }
+    }
+    return runHi - lo;
+}
+
+// n for n < 64, otherwise a length between 32 and 64 that splits n into
+// close to a power of two runs
+static int timSortMinRun(int n) {
+    int r = 0;
+    while (n >= timSortMinMerge) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+/*
+Galloping search in the sorted a[0..len), starting at a[hint]: probes
+hint +- 1, 3, 7, 15, ... until key is bracketed, then binary searches the
+last gap. Costs O(log d) comparisons, d = distance between hint and the result.
+gallopLeft returns the first i with a[i] >= key (key goes before equal elements),
+gallopRight the first i with a[i] > key (key goes after equal elements).
+*/
+static int gallopLeft(int key, const int a[], int len, int hint) {
+    long long lastOfs = 0, ofs = 1;
+    if (SORT_CMP(a[hint] < key)) {
+        // a[hint] < key: gallop right until a[hint + lastOfs] < key <= a[hint + ofs]
+        long long maxOfs = len - hint;
+        while (ofs < maxOfs && SORT_CMP(a[hint + ofs] < key)) {
+            lastOfs = ofs;
+            ofs = 2 * ofs + 1;
+        }
+        ofs = min(ofs, maxOfs);
+        lastOfs += hint;
+        ofs += hint;
+    } else {
+        // key <= a[hint]: gallop left until a[hint - ofs] < key <= a[hint - lastOfs]
+        long long maxOfs = hint + 1;
+        while (ofs < maxOfs && !SORT_CMP(a[hint - ofs] < key)) {
+            lastOfs = ofs;
+            ofs = 2 * ofs + 1;
+        }
+        ofs = min(ofs, maxOfs);
+        long long oldLast = lastOfs;
+        lastOfs = hint - ofs;
+        ofs = hint - oldLast;
+    }
+    // a[lastOfs] < key <= a[ofs] (a[-1] = -inf, a[len] = +inf)
+    lastOfs++;
+    while (lastOfs < ofs) {
+        long long m = lastOfs + (ofs - lastOfs) / 2;
+        if (SORT_CMP(a[m] < key)) {
+            lastOfs = m + 1;
+        } else {
+            ofs = m;
+        }
+    }
+    return static_cast<int>(ofs);
+}
+
+static int gallopRight(int key, const int a[], int len, int hint) {
+    long long lastOfs = 0, ofs = 1;
+    if (SORT_CMP(key < a[hint])) {
+        // key < a[hint]: gallop left until a[hint - ofs] <= key < a[hint - lastOfs]
+        long long maxOfs = hint + 1;
+        while (ofs < maxOfs && SORT_CMP(key < a[hint - ofs])) {
+            lastOfs = ofs;
+            ofs = 2 * ofs + 1;
+        }
+        ofs = min(ofs, maxOfs);
+        long long oldLast = lastOfs;
+        lastOfs = hint - ofs;
+        ofs = hint - oldLast;
+    } else {
+        // a[hint] <= key: gallop right until a[hint + lastOfs] <= key < a[hint + ofs]
+        long long maxOfs = len - hint;
+        while (ofs < maxOfs && !SORT_CMP(key < a[hint + ofs])) {
+            lastOfs = ofs;
+            ofs = 2 * ofs + 1;
+        }
+        ofs = min(ofs, maxOfs);
+        lastOfs += hint;
+        ofs += hint;
+    }
+    // a[lastOfs] <= key < a[ofs]
+    lastOfs++;
+    while (lastOfs < ofs) {
+        long long m = lastOfs + (ofs - lastOfs) / 2;
+        if (SORT_CMP(key < a[m])) {
+            ofs = m;
+        } else {
+            lastOfs = m + 1;
+        }
+    }
+    return static_cast<int>(ofs);
+}
+
+static void moveForward(const int from[], int to[], int count) {
+    for (int i = 0; i < count; i++) {
+        SORT_MOVE(to[i] = from[i]);
+    }
+}
 
-        quickSort(data, left, pi - 1);  // Sort the left part
-        quickSort(data, pi + 1, right); // Sort the right part
+static void moveBackward(const int from[], int to[], int count) {
+    for (int i = count - 1; i >= 0; i--) {
+        SORT_MOVE(to[i] = from[i]);
     }
 }
 
+struct TimSortState {
+    int* data;
+    vector<int> buffer; // grows to the shorter run of the largest merge, at most n / 2
+    vector<int> runBase, runLength; // stack of pending runs
+    int minGallop = timSortMinGallop;
+
+    int* reserve(int size) {
+        if (static_cast<int>(buffer.size()) < size) {
+            buffer.resize(size);
+        }
+        return buffer.data();
+    }
+
+    /*
+    Merges the adjacent runs data[base1..base1+len1) and data[base2..base2+len2)
+    left to right, with the left run in the buffer. Called when len1 <= len2,
+    data[base2] < data[base1] and the last element of the left run is larger
+    than every element of the right run.
+    */
+    void mergeLow(int base1, int len1, int base2, int len2) {
+        int* tmp = reserve(len1);
+        moveForward(data + base1, tmp, len1);
+        int cursor1 = 0, cursor2 = base2, dest = base1;
+
+        SORT_MOVE(data[dest++] = data[cursor2++]);
+        if (--len2 == 0) {
+            moveForward(tmp + cursor1, data + dest, len1);
+            return;
+        }
+        if (len1 == 1) {
+            moveForward(data + cursor2, data + dest, len2);
+            SORT_MOVE(data[dest + len2] = tmp[cursor1]);
+            return;
+        }
+
+        int gallop = minGallop;
+        while (true) {
+            int count1 = 0, count2 = 0; // times in a row the left / right run won
+
+            // One element at a time until one run keeps winning
+            do {
+                if (SORT_CMP(data[cursor2] < tmp[cursor1])) {
+                    SORT_MOVE(data[dest++] = data[cursor2++]);
+                    count2++;
+                    count1 = 0;
+                    if (--len2 == 0) goto done;
+                } else {
+                    SORT_MOVE(data[dest++] = tmp[cursor1++]);
+                    count1++;
+                    count2 = 0;
+                    if (--len1 == 1) goto done;
+                }
+            } while ((count1 | count2) < gallop);
+
+            // Galloping: move whole blocks while that keeps paying off
+            do {
+                count1 = gallopRight(data[cursor2], tmp + cursor1, len1, 0);
+                if (count1 != 0) {
+                    moveForward(tmp + cursor1, data + dest, count1);
+                    dest += count1;
+                    cursor1 += count1;
+                    len1 -= count1;
+                    if (len1 <= 1) goto done;
+                }
+                SORT_MOVE(data[dest++] = data[cursor2++]);
+                if (--len2 == 0) goto done;
+
+                count2 = gallopLeft(tmp[cursor1], data + cursor2, len2, 0);
+                if (count2 != 0) {
+                    moveForward(data + cursor2, data + dest, count2);
+                    dest += count2;
+                    cursor2 += count2;
+                    len2 -= count2;
+                    if (len2 == 0) goto done;
+                }
+                SORT_MOVE(data[dest++] = tmp[cursor1++]);
+                if (--len1 == 1) goto done;
+                gallop--;
+            } while (count1 >= timSortMinGallop || count2 >= timSortMinGallop);
+            gallop = max(gallop, 0) + 2; // penalty for leaving gallop mode
+        }
+
+    done:
+        minGallop = max(gallop, 1);
+        if (len1 == 1) {
+            // The last left element is larger than the rest of the right run
+            moveForward(data + cursor2, data + dest, len2);
+            SORT_MOVE(data[dest + len2] = tmp[cursor1]);
+        } else {
+            moveForward(tmp + cursor1, data + dest, len1);
+        }
+    }
+
+    // Mirror image of mergeLow: right to left, with the right run in the buffer (len1 >= len2)
+    void mergeHigh(int base1, int len1, int base2, int len2) {
+        int* tmp = reserve(len2);
+        moveForward(data + base2, tmp, len2);
+        int cursor1 = base1 + len1 - 1, cursor2 = len2 - 1, dest = base2 + len2 - 1;
+
+        SORT_MOVE(data[dest--] = data[cursor1--]);
+        if (--len1 == 0) {
+            moveForward(tmp, data + dest - (len2 - 1), len2);
+            return;
+        }
+        if (len2 == 1) {
+            dest -= len1;
+            cursor1 -= len1;
+            moveBackward(data + cursor1 + 1, data + dest + 1, len1);
+            SORT_MOVE(data[dest] = tmp[cursor2]);
+            return;
+        }
+
+        int gallop = minGallop;
+        while (true) {
+            int count1 = 0, count2 = 0;
+
+            do {
+                if (SORT_CMP(tmp[cursor2] < data[cursor1])) {
+                    SORT_MOVE(data[dest--] = data[cursor1--]);
+                    count1++;
+                    count2 = 0;
+                    if (--len1 == 0) goto done;
+                } else {
+                    SORT_MOVE(data[dest--] = tmp[cursor2--]);
+                    count2++;
+                    count1 = 0;
+                    if (--len2 == 1) goto done;
+                }
+            } while ((count1 | count2) < gallop);
+
+            do {
+                count1 = len1 - gallopRight(tmp[cursor2], data + base1, len1, len1 - 1);
+                if (count1 != 0) {
+                    dest -= count1;
+                    cursor1 -= count1;
+                    len1 -= count1;
+                    moveBackward(data + cursor1 + 1, data + dest + 1, count1);
+                    if (len1 == 0) goto done;
+                }
+                SORT_MOVE(data[dest--] = tmp[cursor2--]);
+                if (--len2 == 1) goto done;
+
+                count2 = len2 - gallopLeft(data[cursor1], tmp, len2, len2 - 1);
+                if (count2 != 0) {
+                    dest -= count2;
+                    cursor2 -= count2;
+                    len2 -= count2;
+                    moveForward(tmp + cursor2 + 1, data + dest + 1, count2);
+                    if (len2 <= 1) goto done;
+                }
+                SORT_MOVE(data[dest--] = data[cursor1--]);
+                if (--len1 == 0) goto done;
+                gallop--;
+            } while (count1 >= timSortMinGallop || count2 >= timSortMinGallop);
+            gallop = max(gallop, 0) + 2;
+        }
+
+    done:
+        minGallop = max(gallop, 1);
+        if (len2 == 1) {
+            // The first right element is smaller than the rest of the left run
+            dest -= len1;
+            cursor1 -= len1;
+            moveBackward(data + cursor1 + 1, data + dest + 1, len1);
+            SORT_MOVE(data[dest] = tmp[cursor2]);
+        } else {
+            moveForward(tmp, data + dest - (len2 - 1), len2);
+        }
+    }
+
+    // Merges the runs at stack positions i and i + 1
+    void mergeAt(int i) {
+        int base1 = runBase[i], len1 = runLength[i];
+        int base2 = runBase[i + 1], len2 = runLength[i + 1];
+        runLength[i] = len1 + len2;
+        runBase.erase(runBase.begin() + i + 1);
+        runLength.erase(runLength.begin() + i + 1);
+
+        // Elements of the left run not larger than the first right element are already in place
+        int k = gallopRight(data[base2], data + base1, len1, 0);
+        base1 += k;
+        len1 -= k;
+        if (len1 == 0) {
+            return;
+        }
+        // Elements of the right run not smaller than the last left element are already in place
+        len2 = gallopLeft(data[base1 + len1 - 1], data + base2, len2, len2 - 1);
+        if (len2 == 0) {
+            return;
+        }
+        if (len1 <= len2) {
+            mergeLow(base1, len1, base2, len2);
+        } else {
+            mergeHigh(base1, len1, base2, len2);
+        }
+    }
+
+    // Restores the stack invariants after a push. The check reaches three runs
+    // below the top: checking only the top three lets the invariant break deeper down.
+    void mergeCollapse() {
+        while (runLength.size() > 1) {
+            int i = static_cast<int>(runLength.size()) - 2;
+            const vector<int>& len = runLength;
+            if ((i > 0 && len[i - 1] <= len[i] + len[i + 1]) ||
+                (i > 1 && len[i - 2] <= len[i - 1] + len[i])) {
+                if (len[i - 1] < len[i + 1]) {
+                    i--;
+                }
+            } else if (len[i] > len[i + 1]) {
+                break;
+            }
+            mergeAt(i);
+        }
+    }
+
+    void mergeForceCollapse() {
+        while (runLength.size() > 1) {
+            int i = static_cast<int>(runLength.size()) - 2;
+            if (i > 0 && runLength[i - 1] < runLength[i + 1]) {
+                i--;
+            }
+            mergeAt(i);
+        }
+    }
+};
+
+void timSort(int data[], int n) {
+    if (n < 2) {
+        return;
+    }
+    if (n < timSortMinMerge) {
+        // One run plus binary insertion, no merging
+        int run = countRunAndMakeAscending(data, 0, n);
+        binaryInsertionSort(data, 0, n, run);
+        return;
+    }
+
+    TimSortState state;
+    state.data = data;
+    int minRun = timSortMinRun(n);
+    int lo = 0;
+    while (lo < n) {
+        int run = countRunAndMakeAscending(data, lo, n);
+        if (run < minRun) {
+            int forced = min(minRun, n - lo);
+            binaryInsertionSort(data, lo, lo + forced, lo + run);
+            run = forced;
+        }
+        state.runBase.push_back(lo);
+        state.runLength.push_back(run);
+        state.mergeCollapse();
+        lo += run;
+    }
+    state.mergeForceCollapse();
+}
 
 /*
 Time Complexity:
-- Best Case (Pivot divides the array into two equal halves): O(n log n)
-- Worst Case (Pivot is the smallest or largest element): O(n^2)
+- Best Case: O(n), one ascending or descending run (n - 1 comparisons)
+- Worst Case: O(n log n)
+- On k runs: O(n + n log k); a run that lies entirely before or after
+  its neighbour costs O(log n) comparisons to merge thanks to galloping
+
+Space Complexity: a buffer of at most n / 2 elements (the shorter run of a
+merge) and a stack of O(log n) runs.
+
+Notes:
+Stable, like mergeSort. On random input it does slightly more work than a
+plain merge sort; it wins on sorted, reversed, organ-pipe and nearly sorted
+inputs and on concatenations of sorted runs.
+*/
+/////////////////////////////////////////////////////////////////
+// block merge sort (WikiSort)
+/*
+A stable merge sort that needs only O(sqrt n) extra memory instead of n
+elements: a cache of s = sqrt(n) elements and the order of the A blocks
+(n / s indices).
+
+Runs of 16 elements are sorted with binary insertion sort, then merged
+bottom-up. Runs A and B are merged directly through the cache when one of
+them fits in it. Otherwise A is cut into blocks of s elements (plus a
+shorter first block) that are "rolled" through B:
+- while the smallest remaining A block starts after the B block just
+  passed, the leftmost A block is swapped with the next B block (the A
+  blocks move right as a group, in a rotating order)
+- otherwise the smallest A block is dropped in place: the B block just
+  passed is split at its first value, the previous dropped A block (kept
+  in the cache) is merged with the B values up to the split, and the
+  dropped block becomes the next one in the cache
+Every element is moved O(1) times per merge, so a merge is O(n) like a
+buffered one; the price is the extra block swaps and rotations.
+*/
+const int blockMergeLeafSize = 16;
+
+// Swaps data[a..a+count) and data[b..b+count), which do not overlap
+static void blockSwap(int data[], int a, int b, int count) {
+    for (int i = 0; i < count; i++) {
+        SORT_SWAP(data[a + i], data[b + i]);
+    }
+}
+
+static void reverseRange(int data[], int lo, int hi) {
+    for (hi--; lo < hi; lo++, hi--) {
+        SORT_SWAP(data[lo], data[hi]);
+    }
+}
+
+// data[lo..mid) data[mid..hi) -> data[mid..hi) data[lo..mid), in place (three reversals)
+static void rotateRange(int data[], int lo, int mid, int hi) {
+    reverseRange(data, lo, mid);
+    reverseRange(data, mid, hi);
+    reverseRange(data, lo, hi);
+}
+
+// First position in data[lo..hi) whose element is not smaller than value
+static int lowerBound(const int data[], int lo, int hi, int value) {
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (SORT_CMP(data[mid] < value)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Merges cache[0..la), the left run moved out of data[lo..lo+la), with data[lo+la..hi) into data[lo..hi)
+static void mergeFromCache(int data[], const int cache[], int lo, int la, int hi) {
+    int i = 0, j = lo + la, k = lo;
+    while (i < la && j < hi) {
+        if (SORT_CMP(data[j] < cache[i])) {
+            SORT_MOVE(data[k++] = data[j++]);
+        } else {
+            SORT_MOVE(data[k++] = cache[i++]);
+        }
+    }
+    while (i < la) SORT_MOVE(data[k++] = cache[i++]);
+}
+
+// Same from the right: cache[0..lb) is the right run moved out of data[mid..hi)
+static void mergeBackFromCache(int data[], const int cache[], int lo, int mid, int hi) {
+    int i = mid - 1, j = hi - mid - 1, k = hi - 1;
+    while (i >= lo && j >= 0) {
+        if (SORT_CMP(cache[j] < data[i])) {
+            SORT_MOVE(data[k--] = data[i--]);
+        } else {
+            SORT_MOVE(data[k--] = cache[j--]);
+        }
+    }
+    while (j >= 0) SORT_MOVE(data[k--] = cache[j--]);
+}
+
+static void copyToCache(const int data[], int cache[], int count) {
+    for (int i = 0; i < count; i++) {
+        SORT_MOVE(cache[i] = data[i]);
+    }
+}
+
+// Stable merge of data[lo..mid) and data[mid..hi) with a cache of s elements
+static void blockMerge(int data[], int lo, int mid, int hi, int cache[], int s, vector<int>& blockOrder) {
+    if (lo == mid || mid == hi || !SORT_CMP(data[mid] < data[mid - 1])) {
+        return; // already in order
+    }
+    if (SORT_CMP(data[hi - 1] < data[lo])) {
+        rotateRange(data, lo, mid, hi); // all of B goes before A
+        return;
+    }
+    int la = mid - lo, lb = hi - mid;
+    if (la <= s) {
+        copyToCache(data + lo, cache, la);
+        mergeFromCache(data, cache, lo, la, hi);
+        return;
+    }
+    if (lb <= s) {
+        copyToCache(data + mid, cache, lb);
+        mergeBackFromCache(data, cache, lo, mid, hi);
+        return;
+    }
+
+    // The shorter first A block is the first one dropped; it waits in the cache
+    int lastA = lo, lastALength = la % s;
+    copyToCache(data + lo, cache, lastALength);
+    int lastB = lo, lastBEnd = lo; // the B block just passed (empty so far)
+    int blockA = lo + lastALength, blockAEnd = mid;
+    int blockB = mid, blockBEnd = mid + s;
+
+    // blockOrder[j]: position in A of the block now at blockA + j * s
+    blockOrder.clear();
+    for (int j = 0; j < la / s; j++) {
+        blockOrder.push_back(j);
+    }
+
+    while (true) {
+        int minIndex = static_cast<int>(min_element(blockOrder.begin(), blockOrder.end()) - blockOrder.begin());
+        int minA = blockA + minIndex * s;
+
+        if ((lastBEnd > lastB && !SORT_CMP(data[lastBEnd - 1] < data[minA])) || blockB == blockBEnd) {
+            // Drop the smallest A block here, splitting the B block before it
+            int bSplit = lowerBound(data, lastB, lastBEnd, data[minA]);
+            int bRemaining = lastBEnd - bSplit;
+            blockSwap(data, blockA, minA, s);
+            swap(blockOrder[0], blockOrder[minIndex]);
+
+            // The previous A block takes its place among the B values up to the split
+            mergeFromCache(data, cache, lastA, lastALength, bSplit);
+
+            // This block goes to the cache, so its place is free: the rest of the
+            // B block is swapped behind it instead of rotated
+            copyToCache(data + blockA, cache, s);
+            blockSwap(data, bSplit, blockA + s - bRemaining, bRemaining);
+
+            lastA = blockA - bRemaining;
+            lastALength = s;
+            lastB = lastA + s;
+            lastBEnd = lastB + bRemaining;
+            blockA += s;
+            blockOrder.erase(blockOrder.begin());
+            if (blockA == blockAEnd) {
+                break;
+            }
+        } else if (blockBEnd - blockB < s) {
+            // The last, shorter B block goes in front of the remaining A blocks
+            rotateRange(data, blockA, blockB, blockBEnd);
+            lastB = blockA;
+            lastBEnd = blockA + (blockBEnd - blockB);
+            blockA += blockBEnd - blockB;
+            blockAEnd += blockBEnd - blockB;
+            blockB = blockBEnd;
+        } else {
+            // Roll the leftmost A block behind the next B block
+            blockSwap(data, blockA, blockB, s);
+            rotate(blockOrder.begin(), blockOrder.begin() + 1, blockOrder.end());
+            lastB = blockA;
+            lastBEnd = blockA + s;
+            blockA += s;
+            blockAEnd += s;
+            blockB += s;
+            blockBEnd = min(blockBEnd + s, hi);
+        }
+    }
+
+    // The last A block and the B values after it
+    mergeFromCache(data, cache, lastA, lastALength, hi);
+}
+
+void blockMergeSort(int data[], int n) {
+    if (n < 2) {
+        return;
+    }
+    for (int lo = 0; lo < n; lo += blockMergeLeafSize) {
+        binaryInsertionSort(data, lo, min(lo + blockMergeLeafSize, n), lo + 1);
+    }
+
+    int s = blockMergeLeafSize;
+    while (static_cast<long long>(s) * s < n) {
+        s++;
+    }
+    vector<int> cache(s);
+    vector<int> blockOrder;
+    blockOrder.reserve(n / s + 1);
+    for (int width = blockMergeLeafSize; width < n; width *= 2) {
+        for (int lo = 0; lo < n - width; lo += 2 * width) {
+            blockMerge(data, lo, lo + width, static_cast<int>(min<long long>(lo + 2LL * width, n)),
+                       cache.data(), s, blockOrder);
+        }
+    }
+}
+
+/*
+Time Complexity:
+- Best Case: O(n), sorted input (one comparison per merge)
+- Worst Case: O(n log n)
 - Average Case: O(n log n)
 
+Space Complexity: O(sqrt n), a cache of sqrt(n) elements and sqrt(n) block indices.
+
+Notes:
+Stable, like mergeSort. It runs slower than the buffered parallelMergeSort(data, n, 1)
+because of the block swaps and rotations (see sort_benchmark, which reports
+peak_extra_bytes as well).
+*/
+/////////////////////////////////////////////////////////////////
+// quick sort (introsort)
+const int quickLeafSize = 32;
+
+// Index of the median of data[a], data[b], data[c]
+static int medianOfThree(int data[], int a, int b, int c) {
+    if (SORT_CMP(data[a] < data[b])) {
+        if (SORT_CMP(data[b] < data[c])) return b;
+        return SORT_CMP(data[a] < data[c]) ? c : a;
+    }
+    if (SORT_CMP(data[a] < data[c])) return a;
+    return SORT_CMP(data[b] < data[c]) ? c : b;
+}
+
+// Median of three for small ranges, median of three medians (ninther) for large ones
+static int choosePivot(int data[], int left, int right) {
+    int mid = left + (right - left) / 2;
+    int size = right - left + 1;
+    if (size <= 128) {
+        return medianOfThree(data, left, mid, right);
+    }
+    int step = size / 8;
+    int a = medianOfThree(data, left, left + step, left + 2 * step);
+    int b = medianOfThree(data, mid - step, mid, mid + step);
+    int c = medianOfThree(data, right - 2 * step, right - step, right);
+    return medianOfThree(data, a, b, c);
+}
+
+// Three-way partition (Dutch national flag) around the chosen pivot:
+// data[left..lt-1] < pivot, data[lt..gt] == pivot, data[gt+1..right] > pivot
+static void partition(int data[], int left, int right, int& lt, int& gt) {
+    int pivot = data[choosePivot(data, left, right)];
+    int i = left;
+    lt = left;
+    gt = right;
+    while (i <= gt) {
+        if (SORT_CMP(data[i] < pivot)) {
+            SORT_SWAP(data[lt], data[i]);
+            lt++;
+            i++;
+        } else if (SORT_CMP(pivot < data[i])) {
+            SORT_SWAP(data[i], data[gt]); // data[i] is not examined yet, so i stays
+            gt--;
+        } else {
+            i++;
+        }
+    }
+}
+
+static void introSortLoop(int data[], int left, int right, int depthLimit) {
+    while (right - left + 1 > quickLeafSize) {
+        // Too many bad pivots: heap sort guarantees O(n log n) for this range
+        if (depthLimit == 0) {
+            heapSort(data + left, right - left + 1);
+            return;
+        }
+        depthLimit--;
+
+        int lt, gt;
+        partition(data, left, right, lt, gt);
+
+        // Recurse into the smaller part and loop on the larger one,
+        // so the recursion depth stays O(log n)
+        if (lt - left < right - gt) {
+            introSortLoop(data, left, lt - 1, depthLimit);
+            left = gt + 1;
+        } else {
+            introSortLoop(data, gt + 1, right, depthLimit);
+            right = lt - 1;
+        }
+    }
+    networkSort(data + left, right - left + 1);
+}
+
+void quickSort(int data[], int left, int right) {
+    if (left >= right) {
+        return;
+    }
+    // Allow 2 * log2(n) levels of partitioning before falling back to heap sort
+    int depthLimit = 0;
+    for (int size = right - left + 1; size > 1; size /= 2) {
+        depthLimit += 2;
+    }
+    introSortLoop(data, left, right, depthLimit);
+}
+
+
+/*
+Time Complexity:
+- Best Case (all keys equal): O(n), a single three-way partition
+- Worst Case: O(n log n), heap sort takes over after 2 log n bad splits
+- Average Case: O(n log n)
+
+Space Complexity: O(log n) recursion depth
+
 Notes:
 Quick sort is an in-place sorting algorithm and is generally faster than merge sort
 for large datasets. However, its performance depends on the choice of the pivot.
-To improve performance, techniques like random pivot selection or the median-of-three
-method can be used.
-*/
\ No newline at end of file
+Always pivoting on the first element makes sorted and reversed input O(n^2) with
+O(n) recursion depth, so this version (introsort):
+- picks the median of three elements, or the median of three medians (ninther)
+  on large ranges, which handles sorted, reversed and organ-pipe inputs
+- partitions three ways, so runs of equal keys are finished in one pass
+- finishes ranges of up to 32 elements with networkSort, a branch-free SIMD
+  sorting network (insertionSort on CPUs without SIMD)
+- switches to heapSort when the recursion gets deeper than 2 log n
+It is not stable.
+*/
+/////////////////////////////////////////////////////////////////
+// selection (introselect) and partial sort
+/*
+Quick sort recurses into both sides of a partition; to find the element
+of rank k (the one that would be at data[k] after sorting) only the side
+that contains k is needed, and the pivot's equal range ends the search
+when k falls inside it. With the same pivot choice and three-way
+partition as quickSort this takes linear expected time; after 2 log n
+partitions the remaining range is heap sorted, which bounds the worst
+case by O(n log n), like introsort.
+*/
+
+// Partitions data[left..right] until every rank in ranks[first..last] holds its final element
+static void selectRanks(int data[], int left, int right, const int ranks[], int first, int last, int depthLimit) {
+    while (first <= last) {
+        if (right - left + 1 <= quickLeafSize) {
+            networkSort(data + left, right - left + 1);
+            return;
+        }
+        if (depthLimit == 0) {
+            heapSort(data + left, right - left + 1);
+            return;
+        }
+        depthLimit--;
+
+        int lt, gt;
+        partition(data, left, right, lt, gt);
+
+        // ranks[first..below) are left of the pivots, ranks[above..last] right of them
+        int below = first;
+        while (below <= last && ranks[below] < lt) {
+            below++;
+        }
+        int above = below;
+        while (above <= last && ranks[above] <= gt) {
+            above++; // these ranks hold a pivot value: done
+        }
+        // Recurse into the side with fewer ranks, loop on the other one
+        if (below - first < last - above + 1) {
+            selectRanks(data, left, lt - 1, ranks, first, below - 1, depthLimit);
+            left = gt + 1;
+            first = above;
+        } else {
+            selectRanks(data, gt + 1, right, ranks, above, last, depthLimit);
+            right = lt - 1;
+            last = below - 1;
+        }
+    }
+}
+
+static int selectDepthLimit(int n) {
+    int depthLimit = 0;
+    for (int size = n; size > 1; size /= 2) {
+        depthLimit += 2;
+    }
+    return depthLimit;
+}
+
+void nthElement(int data[], int n, int k) {
+    if (k < 0 || k >= n) {
+        return;
+    }
+    int ranks[] = {k};
+    selectRanks(data, 0, n - 1, ranks, 0, 0, selectDepthLimit(n));
+}
+
+void partialSort(int data[], int n, int k) {
+    k = min(k, n);
+    if (k <= 0) {
+        return;
+    }
+    // The k smallest elements go to data[0..k), the largest of them to data[k - 1]
+    nthElement(data, n, k - 1);
+    quickSort(data, 0, k - 2);
+}
+
+void multiSelect(int data[], int n, const int ranks[], int count) {
+    vector<int> sorted;
+    for (int i = 0; i < count; i++) {
+        if (ranks[i] >= 0 && ranks[i] < n) {
+            sorted.push_back(ranks[i]);
+        }
+    }
+    if (sorted.empty()) {
+        return;
+    }
+    sort(sorted.begin(), sorted.end());
+    sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+    selectRanks(data, 0, n - 1, sorted.data(), 0, static_cast<int>(sorted.size()) - 1, selectDepthLimit(n));
+}
+
+/*
+Time Complexity:
+- nthElement: O(n) expected, O(n log n) worst case
+- partialSort: O(n + k log k) expected, O(n log n) worst case
+- multiSelect of m ranks: O(n log m) expected, O(n log n) worst case;
+  all ranks share the partitions near the top of the recursion
+
+Notes:
+After nthElement(data, n, k), data[k] is the element of rank k (0-based),
+data[0..k) holds no larger and data(k..n) no smaller elements, in any order.
+multiSelect gives the same guarantee for every listed rank at once (e.g.
+the percentiles n/100, n/10, n/2, ...); ranks outside [0, n) are ignored.
+The median of data is nthElement(data, n, n / 2).
+*/
@@ -0,0 +1,430 @@
+/*
+External merge sort
+===================
+Sorts a file of integers that is larger than memory.
+
+1. Run generation: the input is read in chunks that fit in the memory
+   budget; every chunk is sorted in memory (radix sort) and written to a
+   temporary run file.
+2. Merge: up to fanIn runs are merged at once with a loser tree
+   (tournament tree): the smallest current element of k runs is found with
+   log2(k) comparisons. If there are more runs than fanIn, groups of runs are
+   merged into longer runs first (several merge passes).
+
+All file I/O goes through large buffers: every run being merged gets an
+equal share of the memory budget, so reads and writes are long and
+sequential.
+
+Input and output are either raw binary 32-bit ints (native byte order)
+or text (whitespace-separated decimal ints; output has one per line).
+
+Build and run:
+  g++ -O2 -std=c++17 -pthread external_sort.cpp non_comparison_sorts.cpp sorting_network.cpp -o external_sort
+  ./external_sort [--text] [--memory MB] [--fan-in K] [--temp DIR] [--threads T] input output
+*/
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <climits>
+#include <random>
+#include <memory>
+#include "sorts.h"
+using namespace std;
+
+struct ExternalSortOptions {
+    size_t memoryBytes = 256u << 20; // budget for one chunk (and its sort buffer) or all merge buffers
+    int fanIn = 64;                  // maximum number of runs merged at once
+    bool text = false;               // text instead of binary input and output
+    string tempDir = ".";
+    int threads = 0;                 // threads for sorting a chunk (0: all)
+};
+
+/////////////////////////////////////////////////////////////////
+// Buffered file access
+static FILE* openFile(const string& path, const char* mode) {
+    FILE* file = fopen(path.c_str(), mode);
+    if (file == nullptr) {
+        throw runtime_error("Cannot open " + path);
+    }
+    return file;
+}
+
+// Reads ints from a binary or text file through a large buffer
+class IntReader {
+private:
+    FILE* file;
+    bool text;
+    vector<char> bytes;
+    size_t pos = 0;
+    size_t size = 0;
+    bool eof = false;
+
+    bool refill() {
+        // keep an unfinished text number at the front of the buffer
+        size_t keep = size - pos;
+        memmove(bytes.data(), bytes.data() + pos, keep);
+        pos = 0;
+        size = keep + fread(bytes.data() + keep, 1, bytes.size() - keep, file);
+        if (ferror(file)) {
+            throw runtime_error("Read error");
+        }
+        eof = size == keep;
+        return !eof;
+    }
+
+    bool readText(int& value) {
+        // skip whitespace
+        while (true) {
+            while (pos < size && (bytes[pos] == ' ' || bytes[pos] == '\n' || bytes[pos] == '\r' || bytes[pos] == '\t')) {
+                pos++;
+            }
+            if (pos < size) break;
+            if (!refill()) return false;
+        }
+        // make sure the whole number is in the buffer (at most 11 characters)
+        if (size - pos < 12 && !eof) {
+            refill();
+        }
+        bool negative = bytes[pos] == '-';
+        if (negative || bytes[pos] == '+') pos++;
+        if (pos >= size || bytes[pos] < '0' || bytes[pos] > '9') {
+            throw runtime_error("Invalid integer in input");
+        }
+        long long magnitude = 0;
+        while (pos < size && bytes[pos] >= '0' && bytes[pos] <= '9') {
+            magnitude = magnitude * 10 + (bytes[pos++] - '0');
+            if (magnitude > 2147483648LL) {
+                throw runtime_error("Integer out of range in input");
+            }
+        }
+        long long result = negative ? -magnitude : magnitude;
+        if (result > INT_MAX) {
+            throw runtime_error("Integer out of range in input");
+        }
+        value = static_cast<int>(result);
+        return true;
+    }
+
+public:
+    IntReader(const string& path, bool isText, size_t bufferBytes)
+        : file(openFile(path, "rb")), text(isText), bytes(max<size_t>(bufferBytes, 4096)) {}
+
+    ~IntReader() {
+        fclose(file);
+    }
+
+    // Reads up to count ints into out, returns how many were read
+    size_t read(int out[], size_t count) {
+        if (!text) {
+            size_t got = 0;
+            while (got < count) {
+                if (pos == size && !refill()) break;
+                size_t available = (size - pos) / sizeof(int);
+                if (available == 0) {
+                    if (!refill()) throw runtime_error("Truncated binary input");
+                    continue;
+                }
+                size_t take = min(available, count - got);
+                memcpy(out + got, bytes.data() + pos, take * sizeof(int));
+                pos += take * sizeof(int);
+                got += take;
+            }
+            return got;
+        }
+        size_t got = 0;
+        while (got < count && readText(out[got])) {
+            got++;
+        }
+        return got;
+    }
+};
+
+// Writes ints to a binary or text file through a large buffer
+class IntWriter {
+private:
+    FILE* file;
+    bool text;
+    vector<char> bytes;
+    size_t size = 0;
+
+    void flush() {
+        if (fwrite(bytes.data(), 1, size, file) != size) {
+            throw runtime_error("Write error");
+        }
+        size = 0;
+    }
+
+public:
+    IntWriter(const string& path, bool isText, size_t bufferBytes)
+        : file(openFile(path, "wb")), text(isText), bytes(max<size_t>(bufferBytes, 4096)) {}
+
+    ~IntWriter() {
+        if (file != nullptr) {
+            fclose(file);
+        }
+    }
+
+    void write(int value) {
+        if (bytes.size() - size < 12) {
+            flush();
+        }
+        if (!text) {
+            memcpy(bytes.data() + size, &value, sizeof(int));
+            size += sizeof(int);
+            return;
+        }
+        // format the digits backwards, then copy them in order
+        char digits[12];
+        int length = 0;
+        long long magnitude = value < 0 ? -static_cast<long long>(value) : value;
+        do {
+            digits[length++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+        if (value < 0) {
+            bytes[size++] = '-';
+        }
+        while (length > 0) {
+            bytes[size++] = digits[--length];
+        }
+        bytes[size++] = '\n';
+    }
+
+    void close() {
+        flush();
+        if (fclose(file) != 0) {
+            file = nullptr;
+            throw runtime_error("Write error");
+        }
+        file = nullptr;
+    }
+};
+
+/////////////////////////////////////////////////////////////////
+// Loser tree
+/*
+A complete binary tree over k sources. Every inner node stores the loser
+(the larger value) of the match played there, and the overall winner is
+kept at node 0. After the winner is consumed only the matches on the path
+from its leaf to the root are replayed: log2(k) comparisons per element,
+half of what a binary heap needs for the same pop-and-push.
+*/
+class LoserTree {
+private:
+    vector<IntReader*> sources;
+    vector<int> current;   // current element of every source
+    vector<bool> finished; // source exhausted: behaves as +infinity
+    vector<int> tree;      // tree[0] = winner, tree[1..k-1] = losers
+    int k;
+
+    bool beats(int a, int b) const {
+        if (finished[a]) return false;
+        if (finished[b]) return true;
+        // ties go to the lower source: runs are merged in order, the merge is stable
+        return SORT_CMP(current[a] < current[b]) || (current[a] == current[b] && a < b);
+    }
+
+    void advance(int s) {
+        finished[s] = sources[s]->read(&current[s], 1) == 0;
+    }
+
+    // Plays the match at node, returns the winner of its subtree
+    int build(int node) {
+        if (node >= k) {
+            return node - k; // leaf of source node - k
+        }
+        int left = build(2 * node);
+        int right = build(2 * node + 1);
+        if (beats(left, right)) {
+            tree[node] = right;
+            return left;
+        }
+        tree[node] = left;
+        return right;
+    }
+
+public:
+    explicit LoserTree(const vector<IntReader*>& runs)
+        : sources(runs), current(runs.size()), finished(runs.size()), tree(runs.size()), k(static_cast<int>(runs.size())) {
+        for (int s = 0; s < k; s++) {
+            advance(s);
+        }
+        tree[0] = k == 1 ? 0 : build(1);
+    }
+
+    bool empty() const {
+        return finished[tree[0]];
+    }
+
+    int top() const {
+        return current[tree[0]];
+    }
+
+    // Replaces the winner by the next element of its source and replays its path
+    void pop() {
+        int winner = tree[0];
+        advance(winner);
+        for (int node = (winner + k) / 2; node > 0; node /= 2) {
+            if (beats(tree[node], winner)) {
+                swap(tree[node], winner);
+            }
+        }
+        tree[0] = winner;
+    }
+};
+
+/////////////////////////////////////////////////////////////////
+// External sort
+// Temporary run files are named extsort_<token>_<pass>_<run>.run; the random token
+// keeps concurrent sorts in the same directory apart
+static string runPath(const ExternalSortOptions& options, const string& token, int pass, int run) {
+    return options.tempDir + "/extsort_" + token + "_" + to_string(pass) + "_" + to_string(run) + ".run";
+}
+
+// Merges the runs into output, with the memory budget split between all buffers
+static void mergeRuns(const vector<string>& runs, const string& output, bool text, const ExternalSortOptions& options) {
+    size_t bufferBytes = options.memoryBytes / (runs.size() + 1);
+    vector<unique_ptr<IntReader>> owners;
+    vector<IntReader*> readers;
+    for (const string& run : runs) {
+        owners.push_back(make_unique<IntReader>(run, false, bufferBytes));
+        readers.push_back(owners.back().get());
+    }
+    IntWriter writer(output, text, bufferBytes);
+    LoserTree tree(readers);
+    while (!tree.empty()) {
+        SORT_MOVE(writer.write(tree.top()));
+        tree.pop();
+    }
+    writer.close();
+}
+
+// Temporary run files still on disk; whatever is left is removed when the
+// sort returns or throws
+class TempRunFiles {
+private:
+    vector<string> paths;
+
+public:
+    TempRunFiles() = default;
+    TempRunFiles(const TempRunFiles&) = delete;
+    TempRunFiles& operator=(const TempRunFiles&) = delete;
+
+    ~TempRunFiles() {
+        for (const string& path : paths) remove(path.c_str());
+    }
+
+    const string& add(const string& path) {
+        paths.push_back(path);
+        return path;
+    }
+
+    // Removes runs that have been merged
+    void discard(const vector<string>& done) {
+        for (const string& path : done) {
+            remove(path.c_str());
+            paths.erase(find(paths.begin(), paths.end(), path));
+        }
+    }
+};
+
+void externalSort(const string& inputPath, const string& outputPath, const ExternalSortOptions& options) {
+    if (options.fanIn < 2) {
+        throw invalid_argument("fanIn must be at least 2");
+    }
+
+    string token = to_string(random_device()());
+    TempRunFiles temp;
+
+    // 1. Run generation: chunk and radix sort buffer share the memory budget
+    size_t chunkSize = max<size_t>(options.memoryBytes / (2 * sizeof(int)), 1024);
+    chunkSize = min<size_t>(chunkSize, INT_MAX);
+    vector<string> runs;
+    {
+        vector<int> chunk(chunkSize);
+        IntReader reader(inputPath, options.text, 1 << 20);
+        while (true) {
+            size_t count = reader.read(chunk.data(), chunkSize);
+            if (count == 0 && !runs.empty()) break;
+            parallelRadixSort(chunk.data(), static_cast<int>(count), options.threads);
+
+            runs.push_back(temp.add(runPath(options, token, 0, static_cast<int>(runs.size()))));
+            IntWriter writer(runs.back(), false, 1 << 20);
+            for (size_t i = 0; i < count; i++) {
+                writer.write(chunk[i]);
+            }
+            writer.close();
+            if (count < chunkSize) break;
+        }
+    }
+
+    // 2. Merge passes until at most fanIn runs are left
+    for (int pass = 1; static_cast<int>(runs.size()) > options.fanIn; pass++) {
+        vector<string> merged;
+        for (size_t first = 0; first < runs.size(); first += options.fanIn) {
+            size_t last = min(runs.size(), first + options.fanIn);
+            vector<string> group(runs.begin() + first, runs.begin() + last);
+            merged.push_back(temp.add(runPath(options, token, pass, static_cast<int>(merged.size()))));
+            mergeRuns(group, merged.back(), false, options);
+            temp.discard(group);
+        }
+        runs.swap(merged);
+    }
+
+    // 3. Final merge into the output format
+    mergeRuns(runs, outputPath, options.text, options);
+    temp.discard(runs);
+}
+
+/*
+Time Complexity:
+- O(n log n) comparisons: n log(chunk) for the runs (O(n) here with radix sort),
+  n log2(k) in every merge pass
+- I/O: every element is read and written once per pass; with r = n / chunk runs
+  there are 1 + ceil(log_fanIn(r)) passes over the data
+
+Space Complexity: the memory budget (chunk + sort buffer, or the merge buffers)
+
+Notes:
+- A larger memory budget gives fewer, longer runs; a larger fan-in fewer merge
+  passes but smaller buffers, so shorter reads per run (more disk seeks).
+- The merge is stable: ties are taken from the earlier run.
+*/
+
+int main(int argc, char* argv[]) {
+    ExternalSortOptions options;
+    vector<string> files;
+    try {
+        for (int i = 1; i < argc; i++) {
+            string arg = argv[i];
+            if (arg == "--text") {
+                options.text = true;
+            } else if (arg == "--memory" && i + 1 < argc) {
+                options.memoryBytes = static_cast<size_t>(stoll(argv[++i])) << 20;
+            } else if (arg == "--fan-in" && i + 1 < argc) {
+                options.fanIn = stoi(argv[++i]);
+            } else if (arg == "--temp" && i + 1 < argc) {
+                options.tempDir = argv[++i];
+            } else if (arg == "--threads" && i + 1 < argc) {
+                options.threads = stoi(argv[++i]);
+            } else {
+                files.push_back(arg);
+            }
+        }
+        if (files.size() != 2) {
+            cerr << "Usage: external_sort [--text] [--memory MB] [--fan-in K] [--temp DIR] [--threads T] input output" << endl;
+            return 1;
+        }
+        externalSort(files[0], files[1], options);
+    } catch (const exception& e) {
+        cerr << "external_sort: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
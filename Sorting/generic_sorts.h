@@ -0,0 +1,400 @@
+// generic_sorts.h
+#ifndef GENERIC_SORTS_H
+#define GENERIC_SORTS_H
+
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "radix_sort.h"
+
+/*
+Generic versions of the sorts in Sorting/ for any element type:
+- first, last: random-access iterators of the range to sort
+- comp(a, b): true when a must come before b (default: a < b)
+- byKey(key): comparator that orders elements by key(element)
+
+    struct Order { uint64_t id; double price; ... };
+    quickSort(orders.begin(), orders.end(), byKey([](const Order& o) { return o.price; }));
+    radixSort(orders.data(), orders.data() + orders.size(), [](const Order& o) { return o.id; });
+
+The int-only versions (sorts.h) are the annotated reference implementations;
+these follow the same algorithms.
+*/
+
+template <class KeyFn>
+auto byKey(KeyFn key) {
+    return [key](const auto& a, const auto& b) { return key(a) < key(b); };
+}
+
+/////////////////////////////////////////////////////////////////
+// insertion sort (quadratic_sorts.cpp)
+template <class RandomIt, class Compare = std::less<>>
+void insertionSort(RandomIt first, RandomIt last, Compare comp = Compare()) {
+    if (last - first < 2) {
+        return;
+    }
+    for (RandomIt i = first + 1; i != last; ++i) {
+        auto key = std::move(*i);
+        RandomIt j = i;
+        for (; j != first && comp(key, *(j - 1)); --j) {
+            *j = std::move(*(j - 1));
+        }
+        *j = std::move(key);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// shell sort (efficient_sorts.cpp)
+template <class RandomIt, class Compare = std::less<>>
+void shellSort(RandomIt first, RandomIt last, Compare comp = Compare()) {
+    auto n = last - first;
+    for (auto gap = n / 2; gap > 0; gap /= 2) {
+        for (auto i = gap; i < n; i++) {
+            auto temp = std::move(first[i]);
+            auto j = i;
+            for (; j >= gap && comp(temp, first[j - gap]); j -= gap) {
+                first[j] = std::move(first[j - gap]);
+            }
+            first[j] = std::move(temp);
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// merge sort (efficient_sorts.cpp, parallelMergeSort)
+// Stable; one buffer of n elements, ping-ponging between it and the range.
+const int genericMergeLeafSize = 32;
+
+// Sorts [left, right) into dst; src and dst hold the same elements there on entry
+template <class SrcIt, class DstIt, class Compare>
+void genericSplitMerge(SrcIt src, DstIt dst, std::ptrdiff_t left, std::ptrdiff_t right, Compare& comp) {
+    if (right - left <= genericMergeLeafSize) {
+        insertionSort(dst + left, dst + right, comp);
+        return;
+    }
+    std::ptrdiff_t mid = left + (right - left) / 2;
+    genericSplitMerge(dst, src, left, mid, comp);
+    genericSplitMerge(dst, src, mid, right, comp);
+
+    std::ptrdiff_t i = left, j = mid, k = left;
+    while (i < mid && j < right) {
+        // take from the right run only when strictly smaller: stable
+        if (comp(src[j], src[i])) {
+            dst[k++] = std::move(src[j++]);
+        } else {
+            dst[k++] = std::move(src[i++]);
+        }
+    }
+    while (i < mid) dst[k++] = std::move(src[i++]);
+    while (j < right) dst[k++] = std::move(src[j++]);
+}
+
+template <class RandomIt, class Compare = std::less<>>
+void mergeSort(RandomIt first, RandomIt last, Compare comp = Compare()) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    std::ptrdiff_t n = last - first;
+    if (n < 2) {
+        return;
+    }
+    std::vector<T> buffer(first, last);
+    genericSplitMerge(buffer.begin(), first, 0, n, comp);
+}
+
+/////////////////////////////////////////////////////////////////
+// heap sort (heap_sort.cpp)
+// Moves first[i] down a max-heap of n elements, shifting larger children up into the hole
+template <class RandomIt, class Compare>
+void siftDown(RandomIt first, std::ptrdiff_t n, std::ptrdiff_t i, Compare& comp) {
+    auto value = std::move(first[i]);
+    while (true) {
+        std::ptrdiff_t child = 2 * i + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && comp(first[child], first[child + 1])) {
+            child++;
+        }
+        if (!comp(value, first[child])) {
+            break;
+        }
+        first[i] = std::move(first[child]);
+        i = child;
+    }
+    first[i] = std::move(value);
+}
+
+template <class RandomIt, class Compare = std::less<>>
+void heapSort(RandomIt first, RandomIt last, Compare comp = Compare()) {
+    std::ptrdiff_t n = last - first;
+    for (std::ptrdiff_t i = n / 2 - 1; i >= 0; i--) {
+        siftDown(first, n, i, comp);
+    }
+    for (std::ptrdiff_t i = n - 1; i > 0; i--) {
+        std::iter_swap(first, first + i);
+        siftDown(first, i, 0, comp);
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// quick sort (introsort, efficient_sorts.cpp)
+const int genericQuickLeafSize = 16;
+
+template <class RandomIt, class Compare>
+RandomIt medianOfThree(RandomIt a, RandomIt b, RandomIt c, Compare& comp) {
+    if (comp(*a, *b)) {
+        if (comp(*b, *c)) return b;
+        return comp(*a, *c) ? c : a;
+    }
+    if (comp(*a, *c)) return a;
+    return comp(*b, *c) ? c : b;
+}
+
+template <class RandomIt, class Compare>
+void genericIntroSortLoop(RandomIt first, RandomIt last, int depthLimit, Compare& comp) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    while (last - first > genericQuickLeafSize) {
+        if (depthLimit == 0) {
+            heapSort(first, last, comp);
+            return;
+        }
+        depthLimit--;
+
+        // Median of three, or ninther on large ranges
+        std::ptrdiff_t size = last - first;
+        RandomIt mid = first + size / 2;
+        RandomIt pivotIt;
+        if (size <= 128) {
+            pivotIt = medianOfThree(first, mid, last - 1, comp);
+        } else {
+            std::ptrdiff_t step = size / 8;
+            pivotIt = medianOfThree(medianOfThree(first, first + step, first + 2 * step, comp),
+                                    medianOfThree(mid - step, mid, mid + step, comp),
+                                    medianOfThree(last - 1 - 2 * step, last - 1 - step, last - 1, comp), comp);
+        }
+        T pivot = *pivotIt;
+
+        // Three-way partition: [first, lt) < pivot, [lt, gt] == pivot, (gt, last) > pivot
+        RandomIt lt = first, i = first, gt = last - 1;
+        while (i <= gt) {
+            if (comp(*i, pivot)) {
+                std::iter_swap(lt++, i++);
+            } else if (comp(pivot, *i)) {
+                std::iter_swap(i, gt--);
+            } else {
+                ++i;
+            }
+        }
+
+        if (lt - first < last - (gt + 1)) {
+            genericIntroSortLoop(first, lt, depthLimit, comp);
+            first = gt + 1;
+        } else {
+            genericIntroSortLoop(gt + 1, last, depthLimit, comp);
+            last = lt;
+        }
+    }
+    insertionSort(first, last, comp);
+}
+
+template <class RandomIt, class Compare = std::less<>>
+void quickSort(RandomIt first, RandomIt last, Compare comp = Compare()) {
+    int depthLimit = 0;
+    for (std::ptrdiff_t size = last - first; size > 1; size /= 2) {
+        depthLimit += 2;
+    }
+    genericIntroSortLoop(first, last, depthLimit, comp);
+}
+
+/////////////////////////////////////////////////////////////////
+// parallel sample sort
+/*
+Splits the range into k buckets by sampled splitters so that every bucket
+can be sorted on its own; unlike parallelMergeSort there is no final merge
+that has to run on few threads.
+1. A random sample of oversampling * k elements is sorted and every
+   oversampling-th element becomes a splitter s[0] <= ... <= s[k-2].
+2. Every thread classifies its slice: element x is in bucket j when
+   s[j-1] < x <= s[j]. The splitters are stored as an implicit binary
+   search tree, so finding j is log2(k) steps of
+       node = 2 * node + comp(tree[node], x)
+   with no data-dependent branch. Elements equal to s[j] go to an
+   equality bucket of their own, which needs no sorting (this keeps many
+   duplicate keys from piling up in one bucket).
+3. A prefix sum in (bucket, thread) order gives every thread its own
+   output range per bucket, and the threads scatter into a buffer.
+4. The buckets, largest first, are taken from a shared counter by the
+   threads, sorted with quickSort (introsort) and moved back.
+*/
+const long long sampleSortMinSize = 1 << 16; // below this (or with one thread) it is quickSort
+const int sampleSortMaxBuckets = 256;
+const long long sampleSortMinBucketSize = 1 << 12;
+
+template <class RandomIt, class Compare = std::less<>>
+void parallelSampleSort(RandomIt first, RandomIt last, Compare comp = Compare(), int threads = 0) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    long long n = last - first;
+    int parts = sortThreadCount(threads);
+    if (parts == 1 || n < sampleSortMinSize) {
+        quickSort(first, last, comp);
+        return;
+    }
+
+    // Number of splitter buckets: a power of two, several per thread
+    int k = 2, levels = 1;
+    while (k < sampleSortMaxBuckets && k < 8 * parts && k * sampleSortMinBucketSize < n) {
+        k *= 2;
+        levels++;
+    }
+
+    // 1. Splitters from a sorted random sample
+    int oversampling = 1;
+    for (long long size = n; size > 1; size /= 2) {
+        oversampling++;
+    }
+    oversampling = std::max(1, oversampling / 4);
+    std::vector<T> sample;
+    sample.reserve(static_cast<size_t>(oversampling) * k);
+    std::mt19937_64 rng(n);
+    for (long long i = 0; i < static_cast<long long>(oversampling) * k; i++) {
+        sample.push_back(first[static_cast<long long>(rng() % static_cast<unsigned long long>(n))]);
+    }
+    quickSort(sample.begin(), sample.end(), comp);
+    std::vector<T> splitters(k - 1);
+    for (int j = 0; j < k - 1; j++) {
+        splitters[j] = sample[static_cast<size_t>(j + 1) * oversampling - 1];
+    }
+    // tree[1..k) is the sorted splitters in breadth-first order (node i has children 2i and 2i + 1)
+    std::vector<T> tree(k);
+    int next = 0;
+    std::function<void(int)> fillTree = [&](int node) {
+        if (node >= k) {
+            return;
+        }
+        fillTree(2 * node);
+        tree[node] = splitters[next++];
+        fillTree(2 * node + 1);
+    };
+    fillTree(1);
+
+    // 2. Classification: bucket 2j for s[j-1] < x < s[j], 2j + 1 for x == s[j] (or x > s[k-2] when j = k-1)
+    const int buckets = 2 * k;
+    std::vector<uint16_t> bucketOf(n);
+    std::vector<long long> offsets(static_cast<size_t>(parts) * buckets, 0);
+    parallelFor(parts, [&](int t) {
+        long long* count = &offsets[static_cast<size_t>(t) * buckets];
+        for (long long i = sliceBegin(n, parts, t); i < sliceBegin(n, parts, t + 1); i++) {
+            const T& x = first[i];
+            int node = 1;
+            for (int level = 0; level < levels; level++) {
+                node = 2 * node + static_cast<int>(comp(tree[node], x));
+            }
+            int j = node - k;
+            int bucket = 2 * j + static_cast<int>(j == k - 1 || !comp(x, splitters[j]));
+            bucketOf[i] = static_cast<uint16_t>(bucket);
+            count[bucket]++;
+        }
+    });
+
+    // 3. Output ranges in (bucket, thread) order, then the scatter
+    std::vector<long long> bucketBegin(buckets + 1);
+    long long offset = 0;
+    for (int b = 0; b < buckets; b++) {
+        bucketBegin[b] = offset;
+        for (int t = 0; t < parts; t++) {
+            long long c = offsets[static_cast<size_t>(t) * buckets + b];
+            offsets[static_cast<size_t>(t) * buckets + b] = offset;
+            offset += c;
+        }
+    }
+    bucketBegin[buckets] = n;
+    std::vector<T> buffer(n);
+    parallelFor(parts, [&](int t) {
+        long long* out = &offsets[static_cast<size_t>(t) * buckets];
+        for (long long i = sliceBegin(n, parts, t); i < sliceBegin(n, parts, t + 1); i++) {
+            buffer[out[bucketOf[i]]++] = std::move(first[i]);
+        }
+    });
+
+    // 4. Sort the buckets (largest first) and move them back
+    std::vector<int> order(buckets);
+    for (int b = 0; b < buckets; b++) {
+        order[b] = b;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return bucketBegin[a + 1] - bucketBegin[a] > bucketBegin[b + 1] - bucketBegin[b];
+    });
+    std::atomic<int> nextBucket{0};
+    parallelFor(parts, [&](int) {
+        for (int i = nextBucket++; i < buckets; i = nextBucket++) {
+            int b = order[i];
+            auto from = buffer.begin() + bucketBegin[b];
+            auto to = buffer.begin() + bucketBegin[b + 1];
+            if (b % 2 == 0 || b == buckets - 1) {
+                quickSort(from, to, comp); // equality buckets are already sorted
+            }
+            std::move(from, to, first + bucketBegin[b]);
+        }
+    });
+}
+
+/*
+Time Complexity: O(n log n / p) expected with p threads; the sample makes
+buckets larger than a few times n / k unlikely.
+Space Complexity: a buffer of n elements and 2 bytes per element for the bucket numbers.
+
+Notes:
+Not stable, like quickSort. The element type must be default-constructible
+(for the buffer) and copyable (for the sample and the splitters).
+*/
+
+/////////////////////////////////////////////////////////////////
+// radix sort (non_comparison_sorts.cpp)
+// Unsigned key with the same order as an integer key (sign bit flipped for
+// signed types) or a float/double key (floatKey / doubleKey, radix_sort.h)
+template <class Number>
+auto orderedKey(Number key) {
+    static_assert(std::is_arithmetic<Number>::value, "radix sort keys must be integers or floating point");
+    if constexpr (std::is_same<Number, float>::value) {
+        return floatKey(key);
+    } else if constexpr (std::is_same<Number, double>::value) {
+        return doubleKey(key);
+    } else if constexpr (std::is_signed<Number>::value) {
+        static_assert(std::is_integral<Number>::value, "long double keys are not supported");
+        using Unsigned = std::make_unsigned_t<Number>;
+        return static_cast<Unsigned>(static_cast<Unsigned>(key) ^ (Unsigned(1) << (sizeof(Unsigned) * 8 - 1)));
+    } else {
+        return static_cast<std::make_unsigned_t<Number>>(key);
+    }
+}
+
+/*
+Sorts the range by key(element), an integer of any width or a float/double, stable.
+Whole elements are moved by the radix passes, so records are sorted
+directly by an embedded key without extracting and permuting keys.
+Pointers sort in place with one n-element buffer; other iterators are
+moved into a temporary array first (pass v.data() for a vector).
+*/
+template <class RandomIt, class Projection>
+void radixSort(RandomIt first, RandomIt last, Projection key) {
+    using T = typename std::iterator_traits<RandomIt>::value_type;
+    long long n = last - first;
+    if (n < 2) {
+        return;
+    }
+    auto toKey = [&key](const T& element) { return orderedKey(key(element)); };
+    std::vector<T> buffer(n);
+    if constexpr (std::is_pointer<RandomIt>::value) {
+        lsdRadixSort(first, buffer.data(), n, toKey);
+    } else {
+        std::vector<T> data(std::make_move_iterator(first), std::make_move_iterator(last));
+        lsdRadixSort(data.data(), buffer.data(), n, toKey);
+        std::move(data.begin(), data.end(), first);
+    }
+}
+
+#endif
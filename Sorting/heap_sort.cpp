@@ -1,23 +1,24 @@
 #include <iostream>
 #include <algorithm>
+#include "sorts.h"
 
 using namespace std;
 
 // heap sort
-void heapify(int data[], int n, int i)
+static void heapify(int data[], int n, int i)
 {
     int largest = i;       // Initialize largest as root
     int left = 2 * i + 1;  // left child index
     int right = 2 * i + 2; // right child index
 
     // If left child is larger than root
-    if (left < n && data[left] > data[largest])
+    if (left < n && SORT_CMP(data[left] > data[largest]))
     {
         largest = left;
     }
 
     // If right child is larger than largest so far
-    if (right < n && data[right] > data[largest])
+    if (right < n && SORT_CMP(data[right] > data[largest]))
     {
         largest = right;
     }
@@ -25,7 +26,7 @@ void heapify(int data[], int n, int i)
     // If largest is not root
     if (largest != i)
     {
-        swap(data[i], data[largest]); // Swap root with largest
+        SORT_SWAP(data[i], data[largest]); // Swap root with largest
 
         // Recursively heapify the affected sub-tree
         heapify(data, n, largest);
@@ -42,7 +43,7 @@ void heapSort(int data[], int n)
     // One by one extract elements from heap
     for (int i = n - 1; i >= 0; i--)
     {
-        swap(data[0], data[i]); // Move current root to end
+        SORT_SWAP(data[0], data[i]); // Move current root to end
         heapify(data, i, 0);    // Call max heapify on the reduced heap
     }
 }
@@ -53,4 +54,73 @@ Time Complexity:
 - Average Case: O(n log n)
 Notes:
 Heap sort is an in-place sorting algorithm. It builds a max heap from the input data and then repeatedly extracts the maximum element from the heap, rebuilding the heap each time. It is not a stable sorting algorithm.
-*/
\ No newline at end of file
+*/
+/////////////////////////////////////////////////////////////////
+// bottom-up heap sort (Floyd)
+/*
+heapify() above swaps at every level (3 moves) and makes 2 comparisons per
+level, although the element sifted down during extraction is the last leaf,
+which is small and almost always sinks back to the bottom. Bottom-up:
+- the element is lifted out, leaving a "hole" at the root
+- the hole walks down to a leaf, always towards the larger child; the child
+  moves up into the hole (1 comparison and 1 move per level)
+- from the leaf, the hole climbs up while the parent is smaller than the
+  element (usually 0-2 levels), then the element is dropped in
+This is about n log n comparisons instead of 2n log n.
+With prefetch, the four grandchildren of the child being examined are
+requested from memory two levels ahead of their use, which helps once the
+heap is larger than the cache.
+*/
+static void siftDownBottomUp(int data[], int n, int root, int value, bool prefetch) {
+    int hole = root;
+    int child = 2 * hole + 1;
+
+    // Walk the hole down to a leaf along the larger children
+    while (child < n) {
+#if defined(__GNUC__)
+        if (prefetch && 4 * child + 3 < n) {
+            __builtin_prefetch(&data[4 * child + 3]); // the 4 grandchildren of child are adjacent
+        }
+#endif
+        if (child + 1 < n && SORT_CMP(data[child] < data[child + 1])) {
+            child++;
+        }
+        SORT_MOVE(data[hole] = data[child]);
+        hole = child;
+        child = 2 * hole + 1;
+    }
+
+    // Climb back up to the place of value
+    while (hole > root) {
+        int parent = (hole - 1) / 2;
+        if (!SORT_CMP(data[parent] < value)) {
+            break;
+        }
+        SORT_MOVE(data[hole] = data[parent]);
+        hole = parent;
+    }
+    SORT_MOVE(data[hole] = value);
+}
+
+void bottomUpHeapSort(int data[], int n, bool prefetch)
+{
+    // Build heap
+    for (int i = n / 2 - 1; i >= 0; i--)
+    {
+        siftDownBottomUp(data, n, i, data[i], prefetch);
+    }
+
+    // Move the root to the end and sift the former last element down from the root
+    for (int i = n - 1; i > 0; i--)
+    {
+        int last = SORT_MOVE(data[i]);
+        SORT_MOVE(data[i] = data[0]);
+        siftDownBottomUp(data, i, 0, last, prefetch);
+    }
+}
+/*
+Time Complexity: O(n log n) in every case, ~n log2 n comparisons
+Space Complexity: O(1), iterative, in place
+Notes:
+Not stable, like heapSort.
+*/
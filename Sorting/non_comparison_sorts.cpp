@@ -1,40 +1,63 @@
 #include <iostream>
 #include <algorithm>
+#include <vector>
+#include <atomic>
+#include <cmath>
+#include "sorts.h"
+#include "radix_sort.h"
+#include "parallel.h"
 
 using namespace std;
 
 // count sort
-void countSort(int data[], int n) {
-    // Find the maximum element in the array
-    int maxElement = *max_element(data, data + n);
-
-    // Create a count array to store the frequency of each element
-    int count[maxElement + 1] = {0};
+// Ranges wider than this many counters per element are handed to radixSort
+const long long countSortRangeFactor = 4;
 
-    // Store the count of each element
-    for (int i = 0; i < n; i++) {
-        count[data[i]]++;
+/*
+count[] is caller-provided scratch of countSize ints (it may be nullptr);
+when it is too small for the key range a heap array is used instead.
+*/
+void countSort(int data[], int n, int count[], long long countSize) {
+    if (n < 2) {
+        return;
     }
+    // Find the minimum and maximum element in one scan
+    pair<int*, int*> extremes = minmax_element(data, data + n);
+    int minElement = *extremes.first;
+    long long range = static_cast<long long>(*extremes.second) - minElement + 1;
 
-    // Modify the count array such that each element at each index
-    // stores the sum of previous counts (cumulative count)
-    for (int i = 1; i <= maxElement; i++) {
-        count[i] += count[i - 1];
+    // A count array much larger than the input costs more than it saves: use radix sort
+    if (range > max(countSortRangeFactor * n, static_cast<long long>(radixBuckets))) {
+        radixSort(data, n);
+        return;
     }
 
-    // Create an output array to store the sorted elements
-    int output[n];
-
-    // Build the output array by placing elements in their correct position
-    for (int i = n - 1; i >= 0; i--) {
-        output[count[data[i]] - 1] = data[i];
-        count[data[i]]--;
+    // Create a count array to store the frequency of each element (offset by the minimum)
+    vector<int> heapCount;
+    if (count == nullptr || countSize < range) {
+        heapCount.resize(range);
+        count = heapCount.data();
     }
+    fill(count, count + range, 0);
 
-    // Copy the sorted elements back to the original array
+    // Store the count of each element
     for (int i = 0; i < n; i++) {
-        data[i] = output[i];
+        count[data[i] - minElement]++;
     }
+
+    // Rewrite the array from the counts: value v appears count[v - min] times.
+    // (Equal ints cannot be told apart, so this gives the same result as
+    // placing each element with cumulative counts, without an output array.)
+    int index = 0;
+    for (long long v = 0; v < range; v++) {
+        for (int c = count[v]; c > 0; c--) {
+            SORT_MOVE(data[index++] = static_cast<int>(minElement + v));
+        }
+    }
+}
+
+void countSort(int data[], int n) {
+    countSort(data, n, nullptr, 0);
 }
 
 /*
@@ -43,14 +66,21 @@ Time Complexity:
 - Worst Case: O(n + k)
 - Average Case: O(n + k)
 
-Where n is the number of elements in the array and k is the range of the input.
+Where n is the number of elements in the array and k is the range of the input
+(max - min + 1). k is kept at most 4n: wider ranges go to radixSort, O(n) for ints.
+
+Space Complexity: O(k) counters, on the heap or in the caller's scratch memory
 
 Notes:
 Count sort is not a comparison-based sorting algorithm. It is efficient for sorting
 integers or objects that can be mapped to integers within a limited range. However,
 it is not suitable for sorting large datasets with a wide range of values due to
 its space complexity.
-stable sort
+Offsetting by the minimum makes negative numbers work and keeps the count array
+as small as the range, not as large as the maximum.
+To sort records by an integer key (stable), the counts are turned into cumulative
+counts and every record is placed at its position in an output array; that is what
+countingSortForRadix does for one digit.
 
 Counting sort array size limitation problem:
 
@@ -62,102 +92,200 @@ Counting sort array size limitation problem:
 */
 /////////////////////////////////////////////////////////////////
 // radix sort
-int getMax(int data[], int n) {
-    int maxElement = data[0];
-    for (int i = 1; i < n; i++) {
-        if (data[i] > maxElement) {
-            maxElement = data[i];
-        }
+/*
+Digits are 8-bit bytes of the key instead of decimal digits: a digit is
+found with a shift and a mask instead of / and %, and a 32-bit int needs
+at most 4 passes instead of 10. The counting-sort passes are done by
+lsdRadixSort (radix_sort.h).
+
+Negative numbers: the sign bit is flipped (signedKey), which maps
+INT_MIN..INT_MAX onto 0..UINT_MAX in the same order.
+*/
+void radixSort(int data[], int n) {
+    if (n < 2) {
+        return;
     }
-    return maxElement;
+    vector<int> buffer(n); // scratch for the passes, on the heap
+    lsdRadixSort(data, buffer.data(), n, signedKey);
 }
 
-void countingSortForRadix(int data[], int n, int exp) {
-    int output[n];
-    int count[10] = {0};
-
-    // Count occurrences of digits
-    for (int i = 0; i < n; i++) {
-        count[(data[i] / exp) % 10]++;
+// Parallel versions (see parallelLsdRadixSort in radix_sort.h), for 32- and 64-bit keys
+void parallelRadixSort(int data[], int n, int threads) {
+    if (n < 2) {
+        return;
     }
+    vector<int> buffer(n);
+    parallelLsdRadixSort(data, buffer.data(), n, signedKey, threads);
+}
 
-    // Update count array to store cumulative counts
-    for (int i = 1; i < 10; i++) {
-        count[i] += count[i - 1];
+void parallelRadixSort(long long data[], long long n, int threads) {
+    if (n < 2) {
+        return;
     }
+    vector<long long> buffer(n);
+    parallelLsdRadixSort(data, buffer.data(), n, signedKey64, threads);
+}
 
-    // Build the output array
-    for (int i = n - 1; i >= 0; i--) {
-        output[count[(data[i] / exp) % 10] - 1] = data[i];
-        count[(data[i] / exp) % 10]--;
-    }
+// float and double keys (floatKey / doubleKey in radix_sort.h): the key is
+// computed from the bits in every pass, so nothing is converted and back
+void radixSort(float data[], long long n) {
+    parallelRadixSort(data, n, 1);
+}
 
-    // Copy the sorted elements back to the original array
-    for (int i = 0; i < n; i++) {
-        data[i] = output[i];
-    }
+void radixSort(double data[], long long n) {
+    parallelRadixSort(data, n, 1);
 }
 
-void radixSort(int data[], int n) {
-    int maxElement = getMax(data, n);
+void parallelRadixSort(float data[], long long n, int threads) {
+    if (n < 2) {
+        return;
+    }
+    vector<float> buffer(n);
+    parallelLsdRadixSort(data, buffer.data(), n, floatKey, threads);
+}
 
-    // Perform counting sort for each digit
-    for (int exp = 1; maxElement / exp > 0; exp *= 10) {
-        countingSortForRadix(data, n, exp);
+void parallelRadixSort(double data[], long long n, int threads) {
+    if (n < 2) {
+        return;
     }
+    vector<double> buffer(n);
+    parallelLsdRadixSort(data, buffer.data(), n, doubleKey, threads);
 }
 
 /*
 Time Complexity:
-- Best Case: O(nk)
+- Best Case: O(n) (one histogram pass when all keys are equal)
 - Worst Case: O(nk)
 - Average Case: O(nk)
 
-Where n is the number of elements in the array and k is the number of digits in the largest number.
+Where n is the number of elements in the array and k is the number of digits (bytes)
+of a key, at most 4 for int. Passes whose digit is the same for every key are skipped,
+so small numbers cost only 1 or 2 passes.
+
+Space Complexity: O(n + 256k) for the buffer and the digit histograms
+
+float and double: k = 4 and 8. Unlike bucketSort there is no assumption on the
+range or distribution of the values; NaNs are sorted too (IEEE-754 totalOrder:
+-NaN first, NaN last, -0.0 before +0.0).
+
+parallelRadixSort: O(nk / p) with p threads, plus O(256 p) histogram entries
+and 256 small staging buffers per thread. It is stable like radixSort.
 
 Notes:
 Radix sort is a non-comparative sorting algorithm. It processes the digits of numbers
 starting from the least significant digit to the most significant digit. It is efficient
 for sorting integers or strings with a fixed length.
+Each pass is a stable counting sort, which is why sorting by a more significant digit
+keeps the order established by the less significant ones.
 */
 //////////////////////////////////////////////////////////
 // bucket sort
-void bucketSort(float data[], int n) {
-    // Create n empty buckets
-    float buckets[n][n]; // 2D array for buckets
-    int bucketSizes[n] = {0}; // Array to track the size of each bucket
-
-    // Put array elements in different buckets
-    for (int i = 0; i < n; i++) {
-        int bucketIndex = n * data[i]; // Index in bucket
-        buckets[bucketIndex][bucketSizes[bucketIndex]++] = data[i];
+/*
+n buckets spread evenly over [min, max] of the input, stored in one flat
+array of n elements:
+1. find min and max
+2. count how many elements fall into every bucket
+3. turn the counts into bucket start positions (prefix sum)
+4. place every element into its bucket in the flat array
+5. sort every bucket: a sorting network (networkSort) for up to 64
+   elements, introsort (std::sort) for the rare larger ones
+With threads > 1, steps 2, 4 and 5 are split over the threads; buckets are
+filled through atomic counters, so memory stays O(n).
+*/
+static void sortBucket(float data[], int n) {
+    if (n > networkSortMax) {
+        sort(data, data + n);
+        return;
     }
+    networkSort(data, n);
+}
 
-    // Sort individual buckets
-    for (int i = 0; i < n; i++) {
-        sort(buckets[i], buckets[i] + bucketSizes[i]);
+void parallelBucketSort(float data[], int n, int threads) {
+    if (n < 2) {
+        return;
+    }
+    pair<float*, float*> extremes = minmax_element(data, data + n);
+    double minElement = *extremes.first;
+    double width = static_cast<double>(*extremes.second) - minElement;
+    if (width == 0) {
+        return; // all elements are equal
     }
+    if (!isfinite(width)) {
+        sort(data, data + n); // infinite values cannot be spread over buckets
+        return;
+    }
+    double scale = n / width;
+    auto bucketOf = [&](float value) {
+        int bucket = static_cast<int>((value - minElement) * scale);
+        return bucket < n ? bucket : n - 1; // the maximum goes to the last bucket
+    };
 
-    // Concatenate all buckets into data[]
-    int index = 0;
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < bucketSizes[i]; j++) {
-            data[index++] = buckets[i][j];
+    int parts = static_cast<int>(min<long long>(sortThreadCount(threads), max(1, n / 65536)));
+    vector<float> buckets(n);
+    vector<int> start(n + 1, 0);
+
+    if (parts == 1) {
+        for (int i = 0; i < n; i++) {
+            start[bucketOf(data[i]) + 1]++;
+        }
+        for (int b = 0; b < n; b++) {
+            start[b + 1] += start[b];
+        }
+        vector<int> next(start.begin(), start.end() - 1);
+        for (int i = 0; i < n; i++) {
+            SORT_MOVE(buckets[next[bucketOf(data[i])]++] = data[i]);
+        }
+    } else {
+        vector<atomic<int>> fill(n);
+        parallelFor(parts, [&](int t) {
+            for (long long i = sliceBegin(n, parts, t); i < sliceBegin(n, parts, t + 1); i++) {
+                fill[bucketOf(data[i])].fetch_add(1, memory_order_relaxed);
+            }
+        });
+        for (int b = 0; b < n; b++) {
+            start[b + 1] = start[b] + fill[b].load(memory_order_relaxed);
+            fill[b].store(start[b], memory_order_relaxed);
         }
+        parallelFor(parts, [&](int t) {
+            for (long long i = sliceBegin(n, parts, t); i < sliceBegin(n, parts, t + 1); i++) {
+                int position = fill[bucketOf(data[i])].fetch_add(1, memory_order_relaxed);
+                SORT_MOVE(buckets[position] = data[i]);
+            }
+        });
     }
+
+    // Sort individual buckets and copy them back, every thread owning a range of buckets
+    parallelFor(parts, [&](int t) {
+        int firstBucket = static_cast<int>(sliceBegin(n, parts, t));
+        int lastBucket = static_cast<int>(sliceBegin(n, parts, t + 1));
+        for (int b = firstBucket; b < lastBucket; b++) {
+            sortBucket(buckets.data() + start[b], start[b + 1] - start[b]);
+        }
+        for (int i = start[firstBucket]; i < start[lastBucket]; i++) {
+            SORT_MOVE(data[i] = buckets[i]);
+        }
+    });
+}
+
+void bucketSort(float data[], int n) {
+    parallelBucketSort(data, n, 1);
 }
 
 /*
 Time Complexity:
 - Best Case: O(n + k)
-- Worst Case: O(n^2) (when all elements are in one bucket)
+- Worst Case: O(n log n) (when all elements are in one bucket, introsort sorts it)
 - Average Case: O(n + k)
 
-Where n is the number of elements and k is the number of buckets.
+Where n is the number of elements and k is the number of buckets (k = n here).
+
+Space Complexity: O(n), one flat array for all buckets and n + 1 bucket starts
+(a separate array per bucket, each large enough for all n elements, would be O(n^2)).
 
 Notes:
 - The performance of bucket sort depends on the distribution of the input data and the number of buckets.
 - It is not a comparison-based sorting algorithm and works well for floating-point numbers or integers within a specific range.
 - The choice of the number of buckets and the method used to sort individual buckets can significantly affect its efficiency.
 - Bucket sort is not suitable for datasets with a large range of values or non-uniform distributions.
+- Any finite range works since the buckets span [min, max] of the input. NaN values are not supported.
 */
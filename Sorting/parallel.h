@@ -0,0 +1,165 @@
+// parallel.h
+#ifndef SORT_PARALLEL_H
+#define SORT_PARALLEL_H
+
+#include <thread>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+/*
+Fork-join helpers shared by the parallel sorts.
+A parallel sort is a sequence of phases (sort slices, merge, scatter...);
+every phase hands its tasks to a pool of worker threads and returns when
+all of them have finished, which is also the barrier between phases. The
+workers are started once, on first use, and reused by every phase of
+every sort.
+*/
+
+// Number of threads to use: `requested`, or every hardware thread when it is 0
+inline int sortThreadCount(int requested) {
+    if (requested > 0) {
+        return requested;
+    }
+    int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    return hardware > 0 ? hardware : 1;
+}
+
+/*
+Worker threads shared by all parallel sorts. A phase is queued as a batch
+of tasks; idle workers take its tasks one at a time, and the calling
+thread runs task 0 and then any task no worker has taken yet, so a batch
+also completes when it is queued from inside another task. The pool grows
+to tasks - 1 workers for the largest batch seen and the threads live until
+the program exits.
+*/
+class SortThreadPool {
+public:
+    static SortThreadPool& instance() {
+        static SortThreadPool pool;
+        return pool;
+    }
+
+    SortThreadPool(const SortThreadPool&) = delete;
+    SortThreadPool& operator=(const SortThreadPool&) = delete;
+
+    ~SortThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Returns when every task has finished; rethrows the first exception a task threw
+    void run(int tasks, const std::function<void(int)>& body) {
+        Batch batch{&body, tasks, 1, tasks, nullptr};
+        {
+            std::lock_guard<std::mutex> lock(m);
+            while (static_cast<int>(workers.size()) < tasks - 1) {
+                workers.emplace_back([this] { work(); });
+            }
+            queue.push_back(&batch);
+        }
+        wake.notify_all();
+
+        execute(batch, 0);
+        std::unique_lock<std::mutex> lock(m);
+        for (int task = claim(batch); task >= 0; task = claim(batch)) {
+            lock.unlock();
+            execute(batch, task);
+            lock.lock();
+        }
+        // batch lives on this stack: wait until no worker uses it any more
+        finished.wait(lock, [&batch] { return batch.remaining == 0; });
+        if (batch.error) {
+            std::rethrow_exception(batch.error);
+        }
+    }
+
+private:
+    struct Batch {
+        const std::function<void(int)>* body;
+        int tasks;
+        int next; // first task nobody has taken
+        int remaining; // tasks not finished
+        std::exception_ptr error;
+    };
+
+    std::mutex m;
+    std::condition_variable wake; // a batch was queued, or the pool stops
+    std::condition_variable finished; // a batch finished its last task
+    std::deque<Batch*> queue; // batches with tasks nobody has taken
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+    SortThreadPool() = default;
+
+    // Takes the next task of batch, -1 when all are taken (m must be held)
+    int claim(Batch& batch) {
+        if (batch.next >= batch.tasks) {
+            return -1;
+        }
+        int task = batch.next++;
+        if (batch.next == batch.tasks) {
+            queue.erase(std::find(queue.begin(), queue.end(), &batch));
+        }
+        return task;
+    }
+
+    // Runs one task; an exception is kept for the caller instead of ending the thread
+    void execute(Batch& batch, int task) {
+        std::exception_ptr error;
+        try {
+            (*batch.body)(task);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(m);
+        if (error && !batch.error) {
+            batch.error = error;
+        }
+        if (--batch.remaining == 0) {
+            finished.notify_all();
+        }
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(m);
+        for (;;) {
+            wake.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return; // stopping
+            }
+            Batch& batch = *queue.front();
+            int task = claim(batch);
+            lock.unlock();
+            execute(batch, task);
+            lock.lock();
+        }
+    }
+};
+
+// Runs body(0) .. body(tasks - 1) in parallel on the pool; task 0 runs on the calling thread.
+// If tasks throw, the first exception is rethrown here once every task has finished.
+inline void parallelFor(int tasks, const std::function<void(int)>& body) {
+    if (tasks == 1) {
+        body(0);
+    } else if (tasks > 1) {
+        SortThreadPool::instance().run(tasks, body);
+    }
+}
+
+// Start of slice t when [0, n) is split into `parts` nearly equal slices
+inline long long sliceBegin(long long n, int parts, int t) {
+    return n * t / parts;
+}
+
+#endif
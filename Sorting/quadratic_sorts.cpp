@@ -6,6 +6,7 @@ The number of movements
 */
 #include <iostream>
 #include <algorithm>
+#include "sorts.h"
 
 using namespace std;
 
@@ -13,18 +14,18 @@ using namespace std;
 void insertionSort(int data[], int n) {
     // Traverse from the second element to the last
     for (int i = 1; i < n; i++) {
-        int key = data[i]; // Store the current element
+        int key = SORT_MOVE(data[i]); // Store the current element
         int j = i - 1;
 
         // Move elements of arr[0..i-1] that are greater than key
         // to one position ahead of their current position
-        while (j >= 0 && data[j] > key) {
-            data[j + 1] = data[j];
+        while (j >= 0 && SORT_CMP(data[j] > key)) {
+            SORT_MOVE(data[j + 1] = data[j]);
             j--;
         }
 
         // Place the key in its correct position
-        data[j + 1] = key;
+        SORT_MOVE(data[j + 1] = key);
     }
 }
 
@@ -50,14 +51,14 @@ void selectionSort(int data[], int n) {
         // Find the minimum element in the unsorted part
         int minIndex = i;
         for (int j = i + 1; j < n; j++) {
-            if (data[j] < data[minIndex]) {
+            if (SORT_CMP(data[j] < data[minIndex])) {
                 minIndex = j;
             }
         }
 
         // Swap the found minimum element with the first element
         if (minIndex != i) {
-            swap(data[i], data[minIndex]);
+            SORT_SWAP(data[i], data[minIndex]);
         }
     }
 }
@@ -85,8 +86,8 @@ void bubbleSort(int data[], int n) {
         // Last i elements are already sorted
         for (int j = 0; j < n - i - 1; j++) {
             // Swap if the element found is greater than the next element
-            if (data[j] > data[j + 1]) {
-                swap(data[j], data[j + 1]);
+            if (SORT_CMP(data[j] > data[j + 1])) {
+                SORT_SWAP(data[j], data[j + 1]);
             }
         }
     }
@@ -115,8 +116,8 @@ void optimizedBubbleSort(int data[], int n) {
     for (int i = 0; i < n - 1; i++) {
         bool swapped = false; // Flag to check if any swaps occurred
         for (int j = 0; j < n - i - 1; j++) {
-            if (data[j] > data[j + 1]) {
-                swap(data[j], data[j + 1]);
+            if (SORT_CMP(data[j] > data[j + 1])) {
+                SORT_SWAP(data[j], data[j + 1]);
                 swapped = true;
             }
         }
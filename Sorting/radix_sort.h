@@ -0,0 +1,236 @@
+// radix_sort.h
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include "sorts.h"
+#include "parallel.h"
+
+/*
+Byte-wise LSD radix sort machinery used by radixSort (non_comparison_sorts.cpp).
+
+Every element is mapped to an unsigned key by a toKey function whose
+unsigned order is the wanted order (e.g. signedKey flips the sign bit so
+negative ints come first). Keys are sorted 8 bits at a time, starting
+with the least significant digit, so a 32-bit key needs at most 4 passes
+and a 64-bit key at most 8.
+*/
+const int radixBits = 8;
+const int radixBuckets = 1 << radixBits;
+const int radixMask = radixBuckets - 1;
+
+// Order-preserving unsigned key of a signed integer
+inline uint32_t signedKey(int value) {
+    return static_cast<uint32_t>(value) ^ 0x80000000u;
+}
+
+inline uint64_t signedKey64(long long value) {
+    return static_cast<uint64_t>(value) ^ 0x8000000000000000ull;
+}
+
+/*
+Order-preserving unsigned key of a float or double (IEEE-754 bits):
+positive numbers already compare like their bits, so only the sign bit
+is set; negative numbers compare in reverse, so all their bits are
+flipped. The result is the IEEE-754 totalOrder:
+-NaN < -inf < ... < -0.0 < +0.0 < ... < +inf < +NaN
+(NaNs with the sign bit set first, all other NaNs last).
+*/
+inline uint32_t floatKey(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits ^ 0x80000000u;
+}
+
+inline uint64_t doubleKey(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x8000000000000000ull) ? ~bits : bits ^ 0x8000000000000000ull;
+}
+
+template <typename Key>
+constexpr int radixPasses() {
+    return (sizeof(Key) * 8 + radixBits - 1) / radixBits;
+}
+
+// One stable counting-sort pass on the digit at `shift` (elements are moved out of src):
+// count[] holds the histogram of that digit and is turned into offsets
+template <typename T, typename ToKey>
+void countingSortForRadix(T src[], T dst[], long long n, int shift, long long count[], ToKey toKey) {
+    long long offset = 0;
+    for (int d = 0; d < radixBuckets; d++) {
+        long long c = count[d];
+        count[d] = offset;
+        offset += c;
+    }
+    for (long long i = 0; i < n; i++) {
+        int digit = static_cast<int>((toKey(src[i]) >> shift) & radixMask);
+        SORT_MOVE(dst[count[digit]++] = std::move(src[i]));
+    }
+}
+
+/*
+Sorts data[0..n) by toKey(element), using buffer[0..n) as scratch.
+- The histograms of all digits are built in a single read of the input.
+- A pass is skipped when every key has the same digit there
+  (e.g. the high bytes of small numbers).
+- Passes ping-pong between data and buffer; the result is copied back
+  only if an odd number of passes ran.
+*/
+template <typename T, typename ToKey>
+void lsdRadixSort(T data[], T buffer[], long long n, ToKey toKey) {
+    using Key = decltype(toKey(data[0]));
+    const int passes = radixPasses<Key>();
+    if (n < 2) {
+        return;
+    }
+
+    std::vector<long long> counts(static_cast<size_t>(passes) * radixBuckets, 0);
+    for (long long i = 0; i < n; i++) {
+        Key key = toKey(data[i]);
+        for (int p = 0; p < passes; p++) {
+            counts[p * radixBuckets + ((key >> (p * radixBits)) & radixMask)]++;
+        }
+    }
+
+    T* src = data;
+    T* dst = buffer;
+    Key firstKey = toKey(data[0]);
+    for (int p = 0; p < passes; p++) {
+        int shift = p * radixBits;
+        long long* count = &counts[p * radixBuckets];
+        if (count[(firstKey >> shift) & radixMask] == n) {
+            continue; // every key has the same digit here
+        }
+        countingSortForRadix(src, dst, n, shift, count, toKey);
+        std::swap(src, dst);
+    }
+
+    if (src != data) {
+        for (long long i = 0; i < n; i++) {
+            SORT_MOVE(data[i] = std::move(src[i]));
+        }
+    }
+}
+
+/*
+Parallel LSD radix sort
+Every pass is split over p threads, each owning a fixed slice of the array:
+1. each thread builds the histogram of the pass digit over its slice
+2. a prefix sum in (digit, thread) order gives every thread its own output
+   range for every digit; the keys of thread t with digit d land after those
+   of threads 0..t-1 with the same digit, so the sort stays stable
+3. the threads scatter concurrently into their disjoint ranges
+The scatter goes through small per-digit staging buffers (write-combining):
+elements are collected per digit and written out a few cache lines at a
+time instead of one element to each of 256 different places.
+*/
+const long long parallelRadixMinSlice = 1 << 16;
+
+template <typename T, typename ToKey>
+void scatterWithBuffers(T src[], long long n, T dst[], long long offset[], int shift, ToKey toKey) {
+    constexpr int lanes = sizeof(T) >= 32 ? 4 : static_cast<int>(128 / sizeof(T));
+    std::vector<T> staging(static_cast<size_t>(radixBuckets) * lanes);
+    int fill[radixBuckets] = {0};
+
+    for (long long i = 0; i < n; i++) {
+        int digit = static_cast<int>((toKey(src[i]) >> shift) & radixMask);
+        T* slot = &staging[digit * lanes];
+        SORT_MOVE(slot[fill[digit]++] = std::move(src[i]));
+        if (fill[digit] == lanes) {
+            std::move(slot, slot + lanes, dst + offset[digit]);
+            offset[digit] += lanes;
+            fill[digit] = 0;
+        }
+    }
+    for (int d = 0; d < radixBuckets; d++) {
+        std::move(&staging[d * lanes], &staging[d * lanes] + fill[d], dst + offset[d]);
+        offset[d] += fill[d];
+    }
+}
+
+template <typename T, typename ToKey>
+void parallelLsdRadixSort(T data[], T buffer[], long long n, ToKey toKey, int threads) {
+    using Key = decltype(toKey(data[0]));
+    const int passes = radixPasses<Key>();
+    int parts = static_cast<int>(std::min<long long>(sortThreadCount(threads), n / parallelRadixMinSlice));
+    if (parts <= 1) {
+        lsdRadixSort(data, buffer, n, toKey);
+        return;
+    }
+
+    // Histograms of every digit per slice, built once to find the passes that can be skipped
+    std::vector<long long> sliceCounts(static_cast<size_t>(parts) * passes * radixBuckets, 0);
+    parallelFor(parts, [&](int t) {
+        long long* counts = &sliceCounts[static_cast<size_t>(t) * passes * radixBuckets];
+        for (long long i = sliceBegin(n, parts, t); i < sliceBegin(n, parts, t + 1); i++) {
+            Key key = toKey(data[i]);
+            for (int p = 0; p < passes; p++) {
+                counts[p * radixBuckets + ((key >> (p * radixBits)) & radixMask)]++;
+            }
+        }
+    });
+
+    std::vector<long long> offsets(static_cast<size_t>(parts) * radixBuckets);
+    T* src = data;
+    T* dst = buffer;
+    bool firstPass = true;
+    for (int p = 0; p < passes; p++) {
+        int shift = p * radixBits;
+        bool trivial = false;
+        for (int d = 0; d < radixBuckets && !trivial; d++) {
+            long long total = 0;
+            for (int t = 0; t < parts; t++) {
+                total += sliceCounts[(static_cast<size_t>(t) * passes + p) * radixBuckets + d];
+            }
+            trivial = total == n;
+        }
+        if (trivial) {
+            continue; // every key has the same digit here
+        }
+
+        // 1. Per-slice histogram of this digit (the initial one is still valid before the first pass)
+        parallelFor(parts, [&](int t) {
+            long long* count = &offsets[static_cast<size_t>(t) * radixBuckets];
+            if (firstPass) {
+                std::copy_n(&sliceCounts[(static_cast<size_t>(t) * passes + p) * radixBuckets], radixBuckets, count);
+                return;
+            }
+            std::fill(count, count + radixBuckets, 0);
+            for (long long i = sliceBegin(n, parts, t); i < sliceBegin(n, parts, t + 1); i++) {
+                count[(toKey(src[i]) >> shift) & radixMask]++;
+            }
+        });
+
+        // 2. Output ranges in (digit, thread) order
+        long long offset = 0;
+        for (int d = 0; d < radixBuckets; d++) {
+            for (int t = 0; t < parts; t++) {
+                long long c = offsets[static_cast<size_t>(t) * radixBuckets + d];
+                offsets[static_cast<size_t>(t) * radixBuckets + d] = offset;
+                offset += c;
+            }
+        }
+
+        // 3. Concurrent scatter
+        parallelFor(parts, [&](int t) {
+            long long begin = sliceBegin(n, parts, t);
+            scatterWithBuffers(src + begin, sliceBegin(n, parts, t + 1) - begin, dst,
+                               &offsets[static_cast<size_t>(t) * radixBuckets], shift, toKey);
+        });
+        std::swap(src, dst);
+        firstPass = false;
+    }
+
+    if (src != data) {
+        parallelFor(parts, [&](int t) {
+            std::move(src + sliceBegin(n, parts, t), src + sliceBegin(n, parts, t + 1), data + sliceBegin(n, parts, t));
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,447 @@
+/*
+Sorting benchmark
+=================
+Runs every routine in Sorting/ against std::sort over several input
+sizes and distributions, checks the output, and writes one CSV row per
+(routine, distribution, n).
+
+Columns:
+- ns_per_element: median time of the repetitions divided by n
+- vs_std_sort: ns_per_element / ns_per_element of std::sort on the same input
+  (string routines: of "std::sort strings", std::sort on the same strings)
+- comparisons, moves: counted per run (only in a -DSORT_STATS build, see sorts.h)
+- peak_extra_bytes: peak heap memory allocated by the sort itself
+  (stack arrays are not visible here)
+
+Distributions: random, sorted, reversed, few_unique, organ_pipe, nearly_sorted,
+sorted_runs. String routines sort the keys written as fixed-width decimals
+after a long common prefix ("https://example.com/customers/0000001234").
+
+Build and run:
+  g++ -O2 -std=c++17 -pthread sort_benchmark.cpp quadratic_sorts.cpp efficient_sorts.cpp \
+      heap_sort.cpp non_comparison_sorts.cpp sorting_network.cpp string_sort.cpp -o sort_benchmark
+  ./sort_benchmark --max-n 100000000 --csv results.csv --label v2
+
+Add -DSORT_STATS to every file to fill the comparisons/moves columns
+(timings of that build include the counting overhead).
+
+Options:
+  --min-n N, --max-n N   size range, n grows by x10 starting at 1000 (default 1000..1000000)
+  --reps R               minimum repetitions per measurement (default 3)
+  --only NAME            run only the routine NAME (and the std::sort baseline)
+  --csv PATH             output file (default sort_benchmark.csv)
+  --label TEXT           value of the "label" column, e.g. a version or commit
+*/
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <atomic>
+#include "sorts.h"
+#include "generic_sorts.h"
+#include "argsort.h"
+using namespace std;
+
+/////////////////////////////////////////////////////////////////
+// Heap memory tracking
+// Every allocation stores its size in front of the block so the
+// current and peak number of live bytes can be followed. The parallel
+// sorts allocate from worker threads, so the counters are atomic.
+static atomic<size_t> liveBytes{0};
+static atomic<size_t> peakBytes{0};
+
+static void* trackedAlloc(size_t size, size_t alignment) {
+    size_t header = alignment < sizeof(size_t) ? sizeof(size_t) : alignment;
+    size_t total = (header + size + alignment - 1) / alignment * alignment;
+    char* block = static_cast<char*>(aligned_alloc(alignment, total));
+    if (block == nullptr) {
+        throw bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(block + header - sizeof(size_t)) = size;
+    size_t live = liveBytes.fetch_add(size, memory_order_relaxed) + size;
+    size_t peak = peakBytes.load(memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {
+    }
+    return block + header;
+}
+
+static void trackedFree(void* ptr, size_t alignment) {
+    if (ptr == nullptr) {
+        return;
+    }
+    size_t header = alignment < sizeof(size_t) ? sizeof(size_t) : alignment;
+    char* block = static_cast<char*>(ptr) - header;
+    liveBytes.fetch_sub(*reinterpret_cast<size_t*>(block + header - sizeof(size_t)), memory_order_relaxed);
+    free(block);
+}
+
+void* operator new(size_t size) { return trackedAlloc(size, alignof(max_align_t)); }
+void* operator new[](size_t size) { return trackedAlloc(size, alignof(max_align_t)); }
+void* operator new(size_t size, align_val_t al) { return trackedAlloc(size, static_cast<size_t>(al)); }
+void* operator new[](size_t size, align_val_t al) { return trackedAlloc(size, static_cast<size_t>(al)); }
+void operator delete(void* ptr) noexcept { trackedFree(ptr, alignof(max_align_t)); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr, alignof(max_align_t)); }
+void operator delete(void* ptr, size_t) noexcept { trackedFree(ptr, alignof(max_align_t)); }
+void operator delete[](void* ptr, size_t) noexcept { trackedFree(ptr, alignof(max_align_t)); }
+void operator delete(void* ptr, align_val_t al) noexcept { trackedFree(ptr, static_cast<size_t>(al)); }
+void operator delete[](void* ptr, align_val_t al) noexcept { trackedFree(ptr, static_cast<size_t>(al)); }
+void operator delete(void* ptr, size_t, align_val_t al) noexcept { trackedFree(ptr, static_cast<size_t>(al)); }
+void operator delete[](void* ptr, size_t, align_val_t al) noexcept { trackedFree(ptr, static_cast<size_t>(al)); }
+
+/////////////////////////////////////////////////////////////////
+// Input distributions
+// Keys are non-negative and smaller than n.
+enum class Distribution { Random, Sorted, Reversed, FewUnique, OrganPipe, NearlySorted, SortedRuns };
+
+const Distribution allDistributions[] = {
+    Distribution::Random, Distribution::Sorted, Distribution::Reversed,
+    Distribution::FewUnique, Distribution::OrganPipe, Distribution::NearlySorted,
+    Distribution::SortedRuns
+};
+
+const char* distributionName(Distribution d) {
+    switch (d) {
+    case Distribution::Random: return "random";
+    case Distribution::Sorted: return "sorted";
+    case Distribution::Reversed: return "reversed";
+    case Distribution::FewUnique: return "few_unique";
+    case Distribution::OrganPipe: return "organ_pipe";
+    case Distribution::NearlySorted: return "nearly_sorted";
+    case Distribution::SortedRuns: return "sorted_runs";
+    }
+    return "?";
+}
+
+vector<int> makeInput(Distribution d, int n, unsigned seed) {
+    mt19937 rng(seed);
+    vector<int> data(n);
+    switch (d) {
+    case Distribution::Random:
+        for (int i = 0; i < n; i++) data[i] = uniform_int_distribution<int>(0, n - 1)(rng);
+        break;
+    case Distribution::Sorted:
+        for (int i = 0; i < n; i++) data[i] = i;
+        break;
+    case Distribution::Reversed:
+        for (int i = 0; i < n; i++) data[i] = n - 1 - i;
+        break;
+    case Distribution::FewUnique:
+        for (int i = 0; i < n; i++) data[i] = uniform_int_distribution<int>(0, 15)(rng);
+        break;
+    case Distribution::OrganPipe:
+        // 0, 1, 2, ..., n/2, ..., 2, 1, 0
+        for (int i = 0; i < n; i++) data[i] = i < n / 2 ? i : n - 1 - i;
+        break;
+    case Distribution::NearlySorted:
+        // sorted with 1% of the elements swapped at random
+        for (int i = 0; i < n; i++) data[i] = i;
+        for (int k = 0; k < n / 100; k++) {
+            uniform_int_distribution<int> pick(0, n - 1);
+            swap(data[pick(rng)], data[pick(rng)]);
+        }
+        break;
+    case Distribution::SortedRuns:
+        // random keys in 16 sorted runs, concatenated
+        for (int i = 0; i < n; i++) data[i] = uniform_int_distribution<int>(0, n - 1)(rng);
+        for (int r = 0; r < 16; r++) {
+            sort(data.begin() + static_cast<long long>(n) * r / 16, data.begin() + static_cast<long long>(n) * (r + 1) / 16);
+        }
+        break;
+    }
+    return data;
+}
+
+bool isOrdered(Distribution d) {
+    return d != Distribution::Random;
+}
+
+/////////////////////////////////////////////////////////////////
+// Routines under test
+// maxN is the largest input a routine is run on; maxNOrdered applies to
+// every distribution except random. They keep quadratic sorts and sorts
+// that put O(n) (or O(n^2)) arrays on the stack out of sizes they
+// cannot survive.
+const long long quadraticLimit = 20000;
+
+struct Routine {
+    string name;
+    long long maxN;
+    long long maxNOrdered;
+    function<void(int*, int)> sortInts;     // empty for float and string routines
+    function<void(float*, int)> sortFloats; // keys are mapped to floats around 0
+    function<void(string*, int)> sortStrings; // keys are mapped to strings with a long common prefix
+};
+
+// Strings hold about 50 bytes each: string routines stop at 10M elements
+const long long stringLimit = 10000000;
+
+vector<Routine> makeRoutines() {
+    const long long unlimited = 1LL << 40;
+    const long long quadratic = quadraticLimit;
+    vector<Routine> routines;
+    // std::sort comparisons are counted through its comparator; its moves are not visible
+    routines.push_back({"std::sort", unlimited, unlimited,
+                        [](int* d, int n) { sort(d, d + n, [](int a, int b) { return SORT_CMP(a < b); }); },
+                        nullptr});
+    routines.push_back({"insertionSort", quadratic, quadratic,
+                        [](int* d, int n) { insertionSort(d, n); }, nullptr});
+    routines.push_back({"selectionSort", quadratic, quadratic, selectionSort, nullptr});
+    routines.push_back({"bubbleSort", quadratic, quadratic, bubbleSort, nullptr});
+    routines.push_back({"optimizedBubbleSort", quadratic, quadratic, optimizedBubbleSort, nullptr});
+    routines.push_back({"shellSort", unlimited, unlimited,
+                        [](int* d, int n) { shellSort(d, n); }, nullptr});
+    // merge() keeps both halves on the stack
+    routines.push_back({"mergeSort", 1000000, 1000000,
+                        [](int* d, int n) { mergeSort(d, 0, n - 1); }, nullptr});
+    routines.push_back({"parallelMergeSort", unlimited, unlimited,
+                        [](int* d, int n) { parallelMergeSort(d, n); }, nullptr});
+    routines.push_back({"parallelMergeSort/1", unlimited, unlimited,
+                        [](int* d, int n) { parallelMergeSort(d, n, 1); }, nullptr});
+    routines.push_back({"timSort", unlimited, unlimited,
+                        [](int* d, int n) { timSort(d, n); }, nullptr});
+    routines.push_back({"blockMergeSort", unlimited, unlimited,
+                        [](int* d, int n) { blockMergeSort(d, n); }, nullptr});
+    routines.push_back({"quickSort", unlimited, unlimited,
+                        [](int* d, int n) { quickSort(d, 0, n - 1); }, nullptr});
+    routines.push_back({"heapSort", unlimited, unlimited,
+                        [](int* d, int n) { heapSort(d, n); }, nullptr});
+    routines.push_back({"bottomUpHeapSort", unlimited, unlimited,
+                        [](int* d, int n) { bottomUpHeapSort(d, n); }, nullptr});
+    routines.push_back({"bottomUpHeapSort+prefetch", unlimited, unlimited,
+                        [](int* d, int n) { bottomUpHeapSort(d, n, true); }, nullptr});
+    routines.push_back({"countSort", unlimited, unlimited,
+                        [](int* d, int n) { countSort(d, n); }, nullptr});
+    routines.push_back({"radixSort", unlimited, unlimited,
+                        [](int* d, int n) { radixSort(d, n); }, nullptr});
+    routines.push_back({"parallelRadixSort", unlimited, unlimited,
+                        [](int* d, int n) { parallelRadixSort(d, n); }, nullptr});
+    // Generic (iterator + comparator) versions; comparisons are counted through the comparator
+    auto less = [](int a, int b) { return SORT_CMP(a < b); };
+    routines.push_back({"generic shellSort", unlimited, unlimited,
+                        [less](int* d, int n) { shellSort(d, d + n, less); }, nullptr});
+    routines.push_back({"generic mergeSort", unlimited, unlimited,
+                        [less](int* d, int n) { mergeSort(d, d + n, less); }, nullptr});
+    routines.push_back({"generic quickSort", unlimited, unlimited,
+                        [less](int* d, int n) { quickSort(d, d + n, less); }, nullptr});
+    routines.push_back({"generic heapSort", unlimited, unlimited,
+                        [less](int* d, int n) { heapSort(d, d + n, less); }, nullptr});
+    routines.push_back({"parallelSampleSort", unlimited, unlimited,
+                        [less](int* d, int n) { parallelSampleSort(d, d + n, less); }, nullptr});
+    routines.push_back({"generic radixSort", unlimited, unlimited,
+                        [](int* d, int n) { radixSort(d, d + n, [](int x) { return x; }); }, nullptr});
+    // Argsort + applying the permutation to the column (the columnar-table path)
+    routines.push_back({"radixArgsort+apply", unlimited, unlimited, [](int* d, int n) {
+                            vector<uint32_t> order = radixArgsort(d, n);
+                            applyPermutation(order.data(), n, d);
+                        }, nullptr});
+    routines.push_back({"quickArgsort+apply", unlimited, unlimited, [less](int* d, int n) {
+                            vector<uint32_t> order = quickArgsort(d, n, less);
+                            applyPermutation(order.data(), n, d);
+                        }, nullptr});
+    routines.push_back({"bucketSort", unlimited, unlimited, nullptr, bucketSort});
+    routines.push_back({"radixSort float", unlimited, unlimited, nullptr,
+                        [](float* d, int n) { radixSort(d, n); }});
+    routines.push_back({"parallelRadixSort float", unlimited, unlimited, nullptr,
+                        [](float* d, int n) { parallelRadixSort(d, n); }});
+    routines.push_back({"parallelBucketSort", unlimited, unlimited, nullptr,
+                        [](float* d, int n) { parallelBucketSort(d, n); }});
+    routines.push_back({"std::sort strings", stringLimit, stringLimit, nullptr, nullptr,
+                        [](string* d, int n) { sort(d, d + n); }});
+    routines.push_back({"stringRadixSort", stringLimit, stringLimit, nullptr, nullptr,
+                        [](string* d, int n) { stringRadixSort(d, n); }});
+    routines.push_back({"parallelStringRadixSort", stringLimit, stringLimit, nullptr, nullptr,
+                        [](string* d, int n) { parallelStringRadixSort(d, n); }});
+    return routines;
+}
+
+/////////////////////////////////////////////////////////////////
+// Measurement
+struct Measurement {
+    double nsPerElement = 0;
+    unsigned long long comparisons = 0;
+    unsigned long long moves = 0;
+    size_t peakExtraBytes = 0;
+    bool correct = true;
+};
+
+Measurement measure(const Routine& routine, const vector<int>& input,
+                    const vector<int>& expected, int reps) {
+    int n = static_cast<int>(input.size());
+    vector<int> work(n);
+    vector<float> floatInput(routine.sortFloats ? n : 0);
+    vector<float> floatWork(floatInput.size());
+    vector<float> floatExpected;
+    vector<string> stringInput(routine.sortStrings ? n : 0);
+    vector<string> stringWork(stringInput.size());
+    vector<string> stringExpected;
+    vector<double> times;
+    Measurement result;
+
+    // Float routines sort a scaled copy of the input, checked against std::sort of the same copy
+    if (routine.sortFloats) {
+        for (int i = 0; i < n; i++) floatInput[i] = static_cast<float>(input[i]) * 0.5f - 1000.0f;
+        floatExpected = floatInput;
+        sort(floatExpected.begin(), floatExpected.end());
+    }
+    if (routine.sortStrings) {
+        char digits[16];
+        for (int i = 0; i < n; i++) {
+            snprintf(digits, sizeof(digits), "%010d", input[i]);
+            stringInput[i] = string("https://example.com/customers/") + digits;
+        }
+        stringExpected = stringInput;
+        sort(stringExpected.begin(), stringExpected.end());
+    }
+
+    for (int rep = 0; rep < reps; rep++) {
+        if (routine.sortFloats) {
+            copy(floatInput.begin(), floatInput.end(), floatWork.begin());
+        } else if (routine.sortStrings) {
+            copy(stringInput.begin(), stringInput.end(), stringWork.begin());
+        } else {
+            copy(input.begin(), input.end(), work.begin());
+        }
+#ifdef SORT_STATS
+        sortStats.comparisons = 0;
+        sortStats.moves = 0;
+#endif
+        size_t baseline = liveBytes.load(memory_order_relaxed);
+        peakBytes.store(baseline, memory_order_relaxed);
+
+        auto start = chrono::steady_clock::now();
+        if (routine.sortFloats) {
+            routine.sortFloats(floatWork.data(), n);
+        } else if (routine.sortStrings) {
+            routine.sortStrings(stringWork.data(), n);
+        } else {
+            routine.sortInts(work.data(), n);
+        }
+        auto stop = chrono::steady_clock::now();
+
+        result.peakExtraBytes = max(result.peakExtraBytes, peakBytes.load(memory_order_relaxed) - baseline);
+        times.push_back(chrono::duration<double, nano>(stop - start).count());
+#ifdef SORT_STATS
+        result.comparisons = sortStats.comparisons;
+        result.moves = sortStats.moves;
+#endif
+        if (rep == 0) {
+            if (routine.sortFloats) {
+                result.correct = floatWork == floatExpected;
+            } else if (routine.sortStrings) {
+                result.correct = stringWork == stringExpected;
+            } else {
+                result.correct = work == expected;
+            }
+        }
+    }
+
+    sort(times.begin(), times.end());
+    result.nsPerElement = times[times.size() / 2] / n;
+    return result;
+}
+
+/////////////////////////////////////////////////////////////////
+struct Options {
+    long long minN = 1000;
+    long long maxN = 1000000;
+    int reps = 3;
+    string only;
+    string csvPath = "sort_benchmark.csv";
+    string label;
+};
+
+Options parseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            throw invalid_argument("Missing value for " + arg);
+        }
+        string value = argv[++i];
+        if (arg == "--min-n") options.minN = stoll(value);
+        else if (arg == "--max-n") options.maxN = stoll(value);
+        else if (arg == "--reps") options.reps = stoi(value);
+        else if (arg == "--only") options.only = value;
+        else if (arg == "--csv") options.csvPath = value;
+        else if (arg == "--label") options.label = value;
+        else throw invalid_argument("Unknown option " + arg);
+    }
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    ofstream csv(options.csvPath);
+    if (!csv) {
+        cerr << "Cannot open " << options.csvPath << endl;
+        return 1;
+    }
+    csv << "label,routine,distribution,n,reps,ns_per_element,vs_std_sort,"
+           "comparisons,moves,peak_extra_bytes,correct\n";
+
+    vector<Routine> routines = makeRoutines();
+    cout << "Sorting network kernel: " << networkSortKernelName() << endl;
+    bool allCorrect = true;
+
+    for (long long n = options.minN; n <= options.maxN; n *= 10) {
+        // aim for a few million sorted elements per measurement on small inputs
+        int reps = max<long long>(options.reps, 4000000 / n);
+        for (Distribution d : allDistributions) {
+            vector<int> input = makeInput(d, static_cast<int>(n), 12345);
+            vector<int> expected = input;
+            sort(expected.begin(), expected.end());
+
+            double baselineNs = 0, stringBaselineNs = 0;
+            for (const Routine& routine : routines) {
+                bool isBaseline = routine.name == "std::sort" || routine.name == "std::sort strings";
+                if (!isBaseline && !options.only.empty() && routine.name != options.only) {
+                    continue;
+                }
+                long long limit = isOrdered(d) ? routine.maxNOrdered : routine.maxN;
+                if (n > limit) {
+                    continue;
+                }
+                int routineReps = limit <= quadraticLimit ? options.reps : reps;
+                Measurement m = measure(routine, input, expected, routineReps);
+                if (isBaseline) {
+                    (routine.sortStrings ? stringBaselineNs : baselineNs) = m.nsPerElement;
+                }
+                double vsStdSort = m.nsPerElement / (routine.sortStrings ? stringBaselineNs : baselineNs);
+                allCorrect = allCorrect && m.correct;
+
+                csv << options.label << ',' << routine.name << ',' << distributionName(d) << ','
+                    << n << ',' << routineReps << ',' << m.nsPerElement << ','
+                    << vsStdSort << ',';
+#ifdef SORT_STATS
+                csv << m.comparisons << ',' << m.moves;
+#else
+                csv << ',';
+#endif
+                csv << ',' << m.peakExtraBytes << ',' << (m.correct ? "yes" : "no") << '\n';
+
+                cout << routine.name << " " << distributionName(d) << " n=" << n << ": "
+                     << m.nsPerElement << " ns/element (x" << vsStdSort
+                     << " std::sort)" << (m.correct ? "" : "  WRONG OUTPUT") << endl;
+            }
+        }
+    }
+
+    cout << "Results written to " << options.csvPath << endl;
+    return allCorrect ? 0 : 2;
+}
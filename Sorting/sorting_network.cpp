@@ -0,0 +1,237 @@
+/*
+Sorting networks for small arrays
+=================================
+A sorting network is a fixed sequence of compare-exchange steps that does
+not depend on the data: there are no data-dependent branches, so no
+branch mispredictions, and every step compares many pairs at once, which
+maps onto SIMD min/max instructions.
+
+networkSort sorts up to 64 ints or floats (the leaf size of the
+divide-and-conquer sorts; longer ranges fall back to insertion sort):
+- the input is padded with the largest value (+inf for floats) up to 8,
+  16, 32 or 64 elements and loaded into vector registers (8 lanes with
+  AVX2, 4 with SSE4.1)
+- Batcher's bitonic sort runs on the registers: when the two elements of a
+  compare-exchange are in different registers it is a vector min/max;
+  when they are in the same register, the register is shuffled against
+  itself and min/max are blended per lane
+- the first n elements are stored back
+
+The instruction set is chosen once at runtime from the CPU features;
+without SSE4.1 (or on other compilers/CPUs) insertion sort is used. Vector
+min/max are not a total order once NaN is involved, so a range containing
+NaN is also sorted by insertion sort.
+Comparisons and moves inside the network are not counted by SORT_STATS.
+*/
+
+#include <iostream>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <limits>
+#include "sorts.h"
+
+using namespace std;
+
+// Scalar fallback: insertion sort (see quadratic_sorts.cpp)
+template <typename T>
+static void insertionSortSmall(T data[], int n) {
+    for (int i = 1; i < n; i++) {
+        T key = SORT_MOVE(data[i]);
+        int j = i - 1;
+        while (j >= 0 && SORT_CMP(data[j] > key)) {
+            SORT_MOVE(data[j + 1] = data[j]);
+            j--;
+        }
+        SORT_MOVE(data[j + 1] = key);
+    }
+}
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && !defined(__clang__)
+#define SORTING_NETWORK_SIMD 1
+
+// GCC vector types: the same code compiles to AVX2 or SSE4.1 instructions
+typedef int Int8 __attribute__((vector_size(32)));
+typedef float Float8 __attribute__((vector_size(32)));
+typedef int Int4 __attribute__((vector_size(16)));
+typedef float Float4 __attribute__((vector_size(16)));
+
+#define NETWORK_INLINE inline __attribute__((always_inline))
+
+// Bitonic sort of Size elements held in Size / Lanes registers
+template <typename Vec, typename Mask, int Lanes, int Size>
+static NETWORK_INLINE void bitonicSortRegisters(Vec v[]) {
+    constexpr int registers = Size / Lanes;
+    Mask lane;
+    for (int l = 0; l < Lanes; l++) {
+        lane[l] = l;
+    }
+
+    for (int k = 2; k <= Size; k *= 2) {
+        for (int j = k / 2; j > 0; j /= 2) {
+            if (registers > 1 && j >= Lanes) {
+                // Partners are in registers r and r ^ (j / Lanes); direction is the same for all lanes
+                for (int r = 0; r < registers; r++) {
+                    int partner = r ^ (j / Lanes);
+                    if (partner < r) {
+                        continue;
+                    }
+                    Vec lo = v[r] < v[partner] ? v[r] : v[partner];
+                    Vec hi = v[r] < v[partner] ? v[partner] : v[r];
+                    bool descending = ((r * Lanes) & k) != 0;
+                    v[r] = descending ? hi : lo;
+                    v[partner] = descending ? lo : hi;
+                }
+            } else {
+                // Partners are lanes l and l ^ j of the same register
+                Mask partnerLane = lane ^ j;
+                for (int r = 0; r < registers; r++) {
+                    Vec swapped = __builtin_shuffle(v[r], partnerLane);
+                    Vec lo = v[r] < swapped ? v[r] : swapped;
+                    Vec hi = v[r] < swapped ? swapped : v[r];
+                    Mask upper = (lane & j) != 0;
+                    Mask descending = ((lane + r * Lanes) & k) != 0;
+                    v[r] = (upper ^ descending) ? hi : lo;
+                }
+            }
+        }
+    }
+}
+
+// Padding sorts behind every real element (+inf for floats, so an infinite input is not replaced by it)
+template <typename T>
+static constexpr T networkPadding() {
+    return numeric_limits<T>::has_infinity ? numeric_limits<T>::infinity() : numeric_limits<T>::max();
+}
+
+template <typename T, typename Vec, typename Mask, int Lanes, int Size>
+static NETWORK_INLINE void networkKernel(T data[], int n) {
+    alignas(32) T buffer[Size];
+    memcpy(buffer, data, n * sizeof(T));
+    fill(buffer + n, buffer + Size, networkPadding<T>());
+
+    Vec v[Size / Lanes];
+    memcpy(v, buffer, sizeof(buffer));
+    bitonicSortRegisters<Vec, Mask, Lanes, Size>(v);
+    memcpy(buffer, v, sizeof(buffer));
+
+    memcpy(data, buffer, n * sizeof(T));
+}
+
+// Smallest network (a power of two, at least one register) that fits n
+template <typename T, typename Vec, typename Mask, int Lanes>
+static NETWORK_INLINE void networkSortLanes(T data[], int n) {
+    if (n <= Lanes) {
+        networkKernel<T, Vec, Mask, Lanes, Lanes>(data, n);
+    } else if (n <= 2 * Lanes) {
+        networkKernel<T, Vec, Mask, Lanes, 2 * Lanes>(data, n);
+    } else if (n <= 16) {
+        networkKernel<T, Vec, Mask, Lanes, 16>(data, n);
+    } else if (n <= 32) {
+        networkKernel<T, Vec, Mask, Lanes, 32>(data, n);
+    } else {
+        networkKernel<T, Vec, Mask, Lanes, 64>(data, n);
+    }
+}
+
+__attribute__((target("avx2"))) void networkSortAvx2(int data[], int n) {
+    networkSortLanes<int, Int8, Int8, 8>(data, n);
+}
+
+__attribute__((target("avx2"))) void networkSortAvx2(float data[], int n) {
+    networkSortLanes<float, Float8, Int8, 8>(data, n);
+}
+
+__attribute__((target("sse4.1"))) void networkSortSse41(int data[], int n) {
+    networkSortLanes<int, Int4, Int4, 4>(data, n);
+}
+
+__attribute__((target("sse4.1"))) void networkSortSse41(float data[], int n) {
+    networkSortLanes<float, Float4, Int4, 4>(data, n);
+}
+#endif
+
+/////////////////////////////////////////////////////////////////
+// Runtime dispatch
+enum class NetworkKernel { Scalar, Sse41, Avx2 };
+
+static NetworkKernel detectNetworkKernel() {
+#ifdef SORTING_NETWORK_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return NetworkKernel::Avx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return NetworkKernel::Sse41;
+    }
+#endif
+    return NetworkKernel::Scalar;
+}
+
+static NetworkKernel activeNetworkKernel() {
+    static const NetworkKernel kernel = detectNetworkKernel();
+    return kernel;
+}
+
+const char* networkSortKernelName() {
+    switch (activeNetworkKernel()) {
+    case NetworkKernel::Avx2: return "avx2";
+    case NetworkKernel::Sse41: return "sse4.1";
+    default: return "scalar";
+    }
+}
+
+// Always false for ints (x != x only holds for NaN)
+template <typename T>
+static bool containsNaN(const T data[], int n) {
+    bool nan = false;
+    for (int i = 0; i < n; i++) {
+        nan |= data[i] != data[i];
+    }
+    return nan;
+}
+
+template <typename T>
+static void networkSortDispatch(T data[], int n) {
+    if (n < 2) {
+        return;
+    }
+#ifdef SORTING_NETWORK_SIMD
+    // The kernels hold at most networkSortMax elements and need a total order (no NaN)
+    if (n > networkSortMax || containsNaN(data, n)) {
+        insertionSortSmall(data, n);
+        return;
+    }
+    switch (activeNetworkKernel()) {
+    case NetworkKernel::Avx2:
+        networkSortAvx2(data, n);
+        return;
+    case NetworkKernel::Sse41:
+        networkSortSse41(data, n);
+        return;
+    default:
+        break;
+    }
+#endif
+    insertionSortSmall(data, n);
+}
+
+void networkSort(int data[], int n) {
+    networkSortDispatch(data, n);
+}
+
+void networkSort(float data[], int n) {
+    networkSortDispatch(data, n);
+}
+
+/*
+Time Complexity:
+- O(m log^2 m) compare-exchanges for a network of m elements (m = 8..64),
+  whatever the input order; all of them run as vector min/max
+- O(n^2) with the insertion sort fallback
+
+Notes:
+Insertion sort wins on tiny or already sorted ranges (O(n) with few branches
+mispredicted), the network wins on random ranges where insertion sort's
+inner loop mispredicts on almost every element.
+*/
@@ -0,0 +1,87 @@
+// sorts.h
+#ifndef SORTS_H
+#define SORTS_H
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*
+Declarations of the sorting routines in Sorting/ so they can be used
+(and benchmarked) together.
+
+Counting comparisons and movements:
+The two factors that determine a sort's performance are the number of
+comparisons and the number of movements (see quadratic_sorts.cpp).
+When compiled with -DSORT_STATS the routines count both in sortStats;
+otherwise the macros below compile to the plain expression.
+- SORT_CMP(expr): one key comparison
+- SORT_MOVE(expr): one element assignment
+- SORT_SWAP(a, b): a swap, counted as three movements
+*/
+#ifdef SORT_STATS
+#include <atomic>
+
+struct SortStats {
+    std::atomic<unsigned long long> comparisons{0};
+    std::atomic<unsigned long long> moves{0};
+};
+inline SortStats sortStats;
+
+#define SORT_CMP(expr) (sortStats.comparisons.fetch_add(1, std::memory_order_relaxed), (expr))
+#define SORT_MOVE(expr) (sortStats.moves.fetch_add(1, std::memory_order_relaxed), (expr))
+#define SORT_SWAP(a, b) (sortStats.moves.fetch_add(3, std::memory_order_relaxed), std::swap((a), (b)))
+#else
+#define SORT_CMP(expr) (expr)
+#define SORT_MOVE(expr) (expr)
+#define SORT_SWAP(a, b) std::swap((a), (b))
+#endif
+
+// quadratic_sorts.cpp
+void insertionSort(int data[], int n);
+void selectionSort(int data[], int n);
+void bubbleSort(int data[], int n);
+void optimizedBubbleSort(int data[], int n);
+
+// efficient_sorts.cpp
+void shellSort(int data[], int n);
+void mergeSort(int data[], int left, int right);
+void parallelMergeSort(int data[], int n, int threads = 0); // threads = 0: all hardware threads
+void timSort(int data[], int n); // stable, adaptive: O(n) on sorted runs
+void blockMergeSort(int data[], int n); // stable, O(sqrt n) extra memory
+void quickSort(int data[], int left, int right);
+// selection: ranks are 0-based positions in sorted order
+void nthElement(int data[], int n, int k); // data[k] gets the element of rank k
+void partialSort(int data[], int n, int k); // the k smallest elements, sorted, in data[0..k)
+void multiSelect(int data[], int n, const int ranks[], int count); // nthElement for several ranks at once
+
+// sorting_network.cpp: SIMD sorting networks for n <= networkSortMax (larger n falls back to insertion sort)
+const int networkSortMax = 64;
+void networkSort(int data[], int n);
+void networkSort(float data[], int n);
+const char* networkSortKernelName(); // "avx2", "sse4.1" or "scalar"
+
+// heap_sort.cpp
+void heapSort(int data[], int n);
+void bottomUpHeapSort(int data[], int n, bool prefetch = false);
+
+// non_comparison_sorts.cpp
+void countSort(int data[], int n);
+void countSort(int data[], int n, int count[], long long countSize); // count: optional scratch
+void radixSort(int data[], int n);
+void parallelRadixSort(int data[], int n, int threads = 0);
+void parallelRadixSort(long long data[], long long n, int threads = 0);
+void radixSort(float data[], long long n); // any values, NaNs included (IEEE-754 totalOrder)
+void radixSort(double data[], long long n);
+void parallelRadixSort(float data[], long long n, int threads = 0);
+void parallelRadixSort(double data[], long long n, int threads = 0);
+void bucketSort(float data[], int n);
+void parallelBucketSort(float data[], int n, int threads = 0);
+
+// string_sort.cpp: MSD radix sort for strings
+void stringRadixSort(std::string data[], long long n);
+void stringRadixSort(std::string_view data[], long long n);
+void parallelStringRadixSort(std::string data[], long long n, int threads = 0);
+void parallelStringRadixSort(std::string_view data[], long long n, int threads = 0);
+
+#endif
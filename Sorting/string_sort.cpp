@@ -0,0 +1,241 @@
+/*
+String sorting
+==============
+Comparison sorts on strings compare from the first character every time,
+so strings with long common prefixes rescan the prefix at every
+comparison. MSD (most significant digit first) radix sort looks at every
+character once per level instead:
+1. the strings of a range are distributed into 257 buckets by their
+   character at position `depth` (bucket 0: the string ends there)
+2. every bucket except bucket 0 (whose strings are all equal) is sorted
+   the same way at depth + 1
+
+Details:
+- The strings themselves are not moved while sorting: (view, row) pairs are.
+  std::string arrays are permuted once at the end.
+- Character cache: the characters at `depth` of a range are read once into
+  a contiguous array, and both the histogram and the scatter read that array
+  instead of going back to every string (one cache miss per string per level).
+- A range whose strings all share the character at `depth` is not
+  distributed; depth just advances, so long common prefixes cost one
+  sequential read per character.
+- Ranges of fewer than 32 strings use insertion sort comparing from `depth`.
+- Pending ranges are kept on an explicit stack, so very long strings do
+  not deepen the call stack.
+- parallelStringRadixSort distributes by the first character on one
+  thread, then the threads take the buckets, largest first.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "sorts.h"
+#include "parallel.h"
+
+using namespace std;
+
+struct StringRef {
+    string_view text;
+    size_t row; // position in the input
+};
+
+const int stringBuckets = 257; // bucket 0: the string has ended, bucket c + 1: character c
+const long long stringInsertionLimit = 32;
+const long long parallelStringMinSize = 1 << 16;
+
+static int bucketAt(const StringRef& s, size_t depth) {
+    return depth < s.text.size() ? static_cast<unsigned char>(s.text[depth]) + 1 : 0;
+}
+
+// Insertion sort of strings that are equal up to depth
+static void insertionSortFrom(StringRef a[], long long n, size_t depth) {
+    for (long long i = 1; i < n; i++) {
+        StringRef key = SORT_MOVE(a[i]);
+        string_view keyRest = key.text.substr(depth);
+        long long j = i;
+        while (j > 0 && SORT_CMP(keyRest < a[j - 1].text.substr(depth))) {
+            SORT_MOVE(a[j] = a[j - 1]);
+            j--;
+        }
+        SORT_MOVE(a[j] = key);
+    }
+}
+
+struct StringSorter {
+    vector<uint16_t> cache;   // bucket of every string of the range being split
+    vector<StringRef> buffer; // scatter target
+    struct Range {
+        long long begin, end;
+        size_t depth;
+    };
+    vector<Range> pending;
+
+    /*
+    Distributes a[0..n) by the character at depth, after advancing depth
+    past the characters all strings share. bucketStart[b] is where bucket b
+    starts (bucketStart[stringBuckets] = n). Returns false when all strings
+    are equal (nothing left to sort).
+    */
+    bool split(StringRef a[], long long n, size_t& depth, long long bucketStart[]) {
+        if (static_cast<long long>(cache.size()) < n) {
+            cache.resize(n);
+            buffer.resize(n);
+        }
+        long long count[stringBuckets];
+        while (true) {
+            fill(count, count + stringBuckets, 0);
+            for (long long i = 0; i < n; i++) {
+                cache[i] = static_cast<uint16_t>(bucketAt(a[i], depth));
+                count[cache[i]]++;
+            }
+            if (count[cache[0]] != n) {
+                break;
+            }
+            if (cache[0] == 0) {
+                return false; // every string ended at the same length: all equal
+            }
+            depth++; // common character
+        }
+
+        long long offset = 0;
+        for (int b = 0; b < stringBuckets; b++) {
+            bucketStart[b] = offset;
+            offset += count[b];
+        }
+        bucketStart[stringBuckets] = n;
+        long long next[stringBuckets];
+        copy(bucketStart, bucketStart + stringBuckets, next);
+        for (long long i = 0; i < n; i++) {
+            SORT_MOVE(buffer[next[cache[i]]++] = a[i]);
+        }
+        for (long long i = 0; i < n; i++) {
+            SORT_MOVE(a[i] = buffer[i]);
+        }
+        return true;
+    }
+
+    // Sorts a[0..n), whose strings are equal up to depth
+    void sort(StringRef a[], long long n, size_t depth) {
+        long long bucketStart[stringBuckets + 1];
+        pending.push_back({0, n, depth});
+        while (!pending.empty()) {
+            Range range = pending.back();
+            pending.pop_back();
+            StringRef* p = a + range.begin;
+            long long size = range.end - range.begin;
+            if (size < stringInsertionLimit) {
+                insertionSortFrom(p, size, range.depth);
+                continue;
+            }
+            size_t d = range.depth;
+            if (!split(p, size, d, bucketStart)) {
+                continue;
+            }
+            for (int b = 1; b < stringBuckets; b++) {
+                if (bucketStart[b + 1] - bucketStart[b] > 1) {
+                    pending.push_back({range.begin + bucketStart[b], range.begin + bucketStart[b + 1], d + 1});
+                }
+            }
+        }
+    }
+};
+
+static void sortRefs(StringRef refs[], long long n, int threads) {
+    int parts = sortThreadCount(threads);
+    if (parts == 1 || n < parallelStringMinSize) {
+        StringSorter().sort(refs, n, 0);
+        return;
+    }
+
+    // Top-level split on this thread, then the buckets in parallel
+    long long bucketStart[stringBuckets + 1];
+    size_t depth = 0;
+    {
+        StringSorter top;
+        if (!top.split(refs, n, depth, bucketStart)) {
+            return;
+        }
+    }
+    vector<int> order;
+    for (int b = 1; b < stringBuckets; b++) {
+        if (bucketStart[b + 1] - bucketStart[b] > 1) {
+            order.push_back(b);
+        }
+    }
+    sort(order.begin(), order.end(), [&](int a, int b) {
+        return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+    });
+    atomic<size_t> next{0};
+    parallelFor(parts, [&](int) {
+        StringSorter sorter;
+        for (size_t i = next++; i < order.size(); i = next++) {
+            int b = order[i];
+            sorter.sort(refs + bucketStart[b], bucketStart[b + 1] - bucketStart[b], depth + 1);
+        }
+    });
+}
+
+void parallelStringRadixSort(string_view data[], long long n, int threads) {
+    if (n < 2) {
+        return;
+    }
+    vector<StringRef> refs(n);
+    for (long long i = 0; i < n; i++) {
+        refs[i] = {data[i], static_cast<size_t>(i)};
+    }
+    sortRefs(refs.data(), n, threads);
+    for (long long i = 0; i < n; i++) {
+        data[i] = refs[i].text;
+    }
+}
+
+void parallelStringRadixSort(string data[], long long n, int threads) {
+    if (n < 2) {
+        return;
+    }
+    vector<StringRef> refs(n);
+    for (long long i = 0; i < n; i++) {
+        refs[i] = {data[i], static_cast<size_t>(i)};
+    }
+    sortRefs(refs.data(), n, threads);
+
+    // Permute the strings once; moving keeps the character buffers in place
+    int parts = static_cast<int>(min<long long>(sortThreadCount(threads), max(1LL, n / parallelStringMinSize)));
+    vector<string> sorted(n);
+    parallelFor(parts, [&](int t) {
+        for (long long i = sliceBegin(n, parts, t); i < sliceBegin(n, parts, t + 1); i++) {
+            sorted[i] = move(data[refs[i].row]);
+        }
+    });
+    parallelFor(parts, [&](int t) {
+        for (long long i = sliceBegin(n, parts, t); i < sliceBegin(n, parts, t + 1); i++) {
+            data[i] = move(sorted[i]);
+        }
+    });
+}
+
+void stringRadixSort(string_view data[], long long n) {
+    parallelStringRadixSort(data, n, 1);
+}
+
+void stringRadixSort(string data[], long long n) {
+    parallelStringRadixSort(data, n, 1);
+}
+
+/*
+Time Complexity: O(D + n) character reads, D = total length of the
+distinguishing prefixes (the characters needed to tell each string from
+all others), plus O(257) per range that is split. A comparison sort does
+O(n log n) comparisons, each of which may rescan a long common prefix.
+
+Space Complexity: the (view, row) pairs, a scratch copy of them and 2 bytes
+of character cache per string; sorting std::string also needs a second
+array of n (moved) strings for the final permutation.
+
+Notes:
+The order is that of std::string (characters compared as unsigned char,
+a prefix before the longer string), and equal strings keep their order.
+*/
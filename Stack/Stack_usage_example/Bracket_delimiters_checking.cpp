@@ -8,8 +8,8 @@ Stack usage example
 */
 // Bracket delimiters checking
 bool areBracketsBalanced(const string& expr) {
-    // Create a stack to store opening brackets
-    Stack stack(expr.length());
+    // Create a stack to store opening brackets (inline up to 64 nested brackets, no allocation)
+    SmallStack<char, 64> stack;
 
     // Iterate through each character in the expression
     for (char ch : expr) {
@@ -4,9 +4,13 @@ using namespace std;
 
 // Big Integer Addition
 string addLargeNumbers(const string& num1, const string& num2) {
-    Stack stack1(num1.length());
-    Stack stack2(num2.length());
-    Stack resultStack(max(num1.length(), num2.length()) + 1);
+    // Numbers of up to 64 digits stay in the stacks' inline storage
+    SmallStack<int, 64> stack1;
+    SmallStack<int, 64> stack2;
+    SmallStack<int, 64> resultStack;
+    stack1.reserve(num1.length());
+    stack2.reserve(num2.length());
+    resultStack.reserve(max(num1.length(), num2.length()) + 1);
 
     // Push digits of num1 onto stack1
     for (char digit : num1) {
@@ -15,7 +15,7 @@ BOA and push it back to the stack
 in the stack is the final answer
 */
 int evaluatePostfix(const string& expression) {
-    Stack stack(expression.length());
+    SmallStack<int, 32> stack; // inline up to 32 pending operands
 
     for (char ch : expression) {
         // If the character is a digit, push it onto the stack
@@ -72,7 +72,7 @@ then push(O) into the stack
 operators remain in the stack
 */
 string convertInfixToPostfix(const string& infixExpression) {
-    Stack operatorStack(infixExpression.length());
+    SmallStack<char, 64> operatorStack; // inline up to 64 pending operators and '('
     string postfixExpression;
 
     for (char currentSymbol : infixExpression) {
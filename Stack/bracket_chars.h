@@ -0,0 +1,25 @@
+// bracket_chars.h
+#ifndef BRACKET_CHARS_H
+#define BRACKET_CHARS_H
+
+// The bracket pairs () [] {}, shared by bracket_validator.cpp and
+// incremental_bracket_checker.cpp
+
+inline bool isOpeningBracket(char c) {
+    return c == '(' || c == '[' || c == '{';
+}
+
+inline bool isClosingBracket(char c) {
+    return c == ')' || c == ']' || c == '}';
+}
+
+inline bool isBracketChar(char c) {
+    return isOpeningBracket(c) || isClosingBracket(c);
+}
+
+// ')' -> '(' (0x29 -> 0x28), ']' -> '[' and '}' -> '{' (2 apart)
+inline char openingBracketOf(char c) {
+    return c == ')' ? '(' : static_cast<char>(c - 2);
+}
+
+#endif
@@ -0,0 +1,330 @@
+/*
+Bracket validation for large inputs (see bracket_validator.h)
+
+Chunk summaries:
+Inside a chunk, the brackets that match each other cancel out exactly as
+with the stack of areBracketsBalanced. What cannot be matched inside the
+chunk is a run of closing brackets (their openers are in an earlier chunk)
+followed by a run of opening brackets (closed in a later chunk):
+    "])}  ...  ([{"   <- "]) ( [] ) } (( ) [{" reduces to this
+Combining the chunks from left to right with one stack: the closers of a
+chunk pop the openers left by the previous chunks (a wrong type or an
+empty stack is a mismatch), then its openers are pushed.
+The summaries are small for real inputs (their size is bounded by the
+nesting depth), so combining costs nothing next to scanning.
+
+Skipping non-bracket bytes:
+The six brackets are ( ) [ ] { } = 0x28 0x29 0x5B 0x5D 0x7B 0x7D. A block
+of 32 (AVX2) or 16 (SSE2) bytes is compared with them at once; the
+comparison results form a bit mask with one bit per bracket, and only
+those bytes are looked at one by one. Text that is mostly not brackets
+(strings, numbers, keys) costs a few instructions per block.
+As in sorting_network.cpp, the instruction set is chosen at runtime.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bracket_chars.h"
+#include "bracket_validator.h"
+#include "../Sorting/parallel.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BRACKET_SIMD 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+const size_t bracketBlockSize = 1 << 20; // read(2) size, and how often threads check for a failure
+const size_t parallelBracketMinSize = 1 << 20; // smaller inputs are scanned by one thread
+
+/*
+The openers of a summary while a chunk is scanned. items[0] is a sentinel
+below the bottom, so the top can always be read, and one bracket is
+handled without branching on its type: the bracket is written above the
+top (kept only if it is an opener), the top is compared with the opener
+it would need (ignored if it is an opener), and the depth moves by +1 or
+-1. Open and close alternate unpredictably in dense input, where the
+obvious if/else costs a branch misprediction every other bracket.
+*/
+struct OpenerStack {
+    vector<char> items;
+    size_t depth;
+
+    explicit OpenerStack(const string& openers) : items(openers.size() + 64), depth(openers.size()) {
+        items[0] = 0;
+        copy(openers.begin(), openers.end(), items.begin() + 1);
+    }
+
+    void store(string& openers) const { openers.assign(items.begin() + 1, items.begin() + 1 + depth); }
+};
+
+// One bracket; returns false on a mismatch (the summary is then final)
+static inline bool bracketStep(OpenerStack& stack, string& closers, char c) {
+    bool opening = isOpeningBracket(c);
+    if (stack.depth == 0 && !opening) {
+        closers.push_back(c); // matches an opener before the chunk
+        return true;
+    }
+    if (stack.depth + 2 > stack.items.size()) {
+        stack.items.resize(2 * stack.items.size());
+    }
+    char top = stack.items[stack.depth];
+    stack.items[stack.depth + 1] = c;
+    bool mismatch = !opening & (top != openingBracketOf(c));
+    stack.depth += opening ? 1 : -1;
+    return !mismatch;
+}
+
+static inline bool isBracket(char c) {
+    return (c & 0xFE) == 0x28 || c == '[' || c == ']' || c == '{' || c == '}';
+}
+
+// Returns false on a mismatch
+static bool scanBracketsScalar(const char data[], size_t n, OpenerStack& stack, string& closers) {
+    for (size_t i = 0; i < n; i++) {
+        if (isBracket(data[i]) && !bracketStep(stack, closers, data[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef BRACKET_SIMD
+static __attribute__((target("avx2"))) bool scanBracketsAvx2(const char data[], size_t n, OpenerStack& stack, string& closers) {
+    const __m256i evenMask = _mm256_set1_epi8(static_cast<char>(0xFE));
+    const __m256i paren = _mm256_set1_epi8('(');
+    const __m256i squareOpen = _mm256_set1_epi8('[');
+    const __m256i squareClose = _mm256_set1_epi8(']');
+    const __m256i curlyOpen = _mm256_set1_epi8('{');
+    const __m256i curlyClose = _mm256_set1_epi8('}');
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_and_si256(bytes, evenMask), paren),
+                            _mm256_cmpeq_epi8(bytes, squareOpen)),
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, squareClose), _mm256_cmpeq_epi8(bytes, curlyOpen)),
+                            _mm256_cmpeq_epi8(bytes, curlyClose)));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        while (mask != 0) {
+            if (!bracketStep(stack, closers, data[i + __builtin_ctz(mask)])) {
+                return false;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return scanBracketsScalar(data + i, n - i, stack, closers);
+}
+
+static __attribute__((target("sse2"))) bool scanBracketsSse2(const char data[], size_t n, OpenerStack& stack, string& closers) {
+    const __m128i evenMask = _mm_set1_epi8(static_cast<char>(0xFE));
+    const __m128i paren = _mm_set1_epi8('(');
+    const __m128i squareOpen = _mm_set1_epi8('[');
+    const __m128i squareClose = _mm_set1_epi8(']');
+    const __m128i curlyOpen = _mm_set1_epi8('{');
+    const __m128i curlyClose = _mm_set1_epi8('}');
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(_mm_and_si128(bytes, evenMask), paren), _mm_cmpeq_epi8(bytes, squareOpen)),
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, squareClose), _mm_cmpeq_epi8(bytes, curlyOpen)),
+                         _mm_cmpeq_epi8(bytes, curlyClose)));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        while (mask != 0) {
+            if (!bracketStep(stack, closers, data[i + __builtin_ctz(mask)])) {
+                return false;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return scanBracketsScalar(data + i, n - i, stack, closers);
+}
+#endif
+
+/////////////////////////////////////////////////////////////////
+// Runtime dispatch
+enum class BracketKernel { Scalar, Sse2, Avx2 };
+
+static BracketKernel detectBracketKernel() {
+#ifdef BRACKET_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return BracketKernel::Avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return BracketKernel::Sse2;
+    }
+#endif
+    return BracketKernel::Scalar;
+}
+
+static BracketKernel activeBracketKernel() {
+    static const BracketKernel kernel = detectBracketKernel();
+    return kernel;
+}
+
+const char* bracketKernelName() {
+    switch (activeBracketKernel()) {
+    case BracketKernel::Avx2: return "avx2";
+    case BracketKernel::Sse2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+void scanBrackets(const char data[], size_t n, BracketSummary& summary) {
+    if (summary.mismatch) {
+        return;
+    }
+    OpenerStack stack(summary.openers);
+    bool matched;
+    switch (activeBracketKernel()) {
+#ifdef BRACKET_SIMD
+    case BracketKernel::Avx2:
+        matched = scanBracketsAvx2(data, n, stack, summary.closers);
+        break;
+    case BracketKernel::Sse2:
+        matched = scanBracketsSse2(data, n, stack, summary.closers);
+        break;
+#endif
+    default:
+        matched = scanBracketsScalar(data, n, stack, summary.closers);
+        break;
+    }
+    summary.mismatch = !matched;
+    stack.store(summary.openers);
+}
+
+bool combineBracketSummaries(const vector<BracketSummary>& parts) {
+    string open; // openers left by the chunks combined so far
+    for (const BracketSummary& part : parts) {
+        if (part.mismatch) {
+            return false;
+        }
+        for (char c : part.closers) {
+            if (open.empty() || open.back() != openingBracketOf(c)) {
+                return false;
+            }
+            open.pop_back();
+        }
+        open += part.openers;
+    }
+    return open.empty();
+}
+
+/////////////////////////////////////////////////////////////////
+// Entry points
+bool validateBrackets(const char data[], size_t n) {
+    BracketSummary summary;
+    scanBrackets(data, n, summary);
+    return !summary.mismatch && summary.closers.empty() && summary.openers.empty();
+}
+
+/*
+Every thread summarises one slice of the input. A slice is scanned in
+blocks so that the threads stop soon after one of them finds a mismatch
+(or a closer that nothing before the whole input can match: one in the
+first slice).
+*/
+bool parallelValidateBrackets(const char data[], size_t n, int threads) {
+    int parts = sortThreadCount(threads);
+    if (n < parallelBracketMinSize || parts == 1) {
+        return validateBrackets(data, n);
+    }
+    parts = static_cast<int>(min<size_t>(parts, n / (parallelBracketMinSize / 4)));
+    vector<BracketSummary> summaries(parts);
+    atomic<bool> failed{false};
+    parallelFor(parts, [&](int t) {
+        size_t begin = sliceBegin(n, parts, t);
+        size_t end = sliceBegin(n, parts, t + 1);
+        BracketSummary& summary = summaries[t];
+        for (size_t block = begin; block < end && !failed.load(memory_order_relaxed); block += bracketBlockSize) {
+            scanBrackets(data + block, min(bracketBlockSize, end - block), summary);
+            if (summary.mismatch || (t == 0 && !summary.closers.empty())) {
+                failed.store(true, memory_order_relaxed);
+            }
+        }
+    });
+    return !failed.load() && combineBracketSummaries(summaries);
+}
+
+/*
+Regular files are mapped and validated like an array in memory (pages are
+read on first access and can be dropped again by the kernel, so the
+process does not hold the file). Pipes, sockets and terminals are read in
+bracketBlockSize blocks by one thread.
+*/
+// The input starts at the current offset of fd; mappings start on a page boundary,
+// so the bytes before the offset are skipped
+bool validateBracketsFd(int fd, int threads) {
+    struct stat info;
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && offset >= 0) {
+        if (offset >= info.st_size) {
+            return true;
+        }
+        off_t start = offset - offset % sysconf(_SC_PAGESIZE);
+        size_t size = info.st_size - start;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, start);
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            size_t skip = offset - start;
+            bool balanced = parallelValidateBrackets(static_cast<const char*>(mapped) + skip, size - skip, threads);
+            munmap(mapped, size);
+            lseek(fd, 0, SEEK_END); // consumed, like the input of the read(2) loop
+            return balanced;
+        }
+    }
+    vector<char> buffer(bracketBlockSize);
+    BracketSummary summary;
+    for (;;) {
+        ssize_t got;
+        do {
+            got = read(fd, buffer.data(), buffer.size());
+        } while (got < 0 && errno == EINTR);
+        if (got < 0) {
+            throw runtime_error("validateBracketsFd: read failed");
+        }
+        if (got == 0) {
+            break;
+        }
+        scanBrackets(buffer.data(), got, summary);
+        if (summary.mismatch || !summary.closers.empty()) {
+            return false;
+        }
+    }
+    return summary.openers.empty();
+}
+
+bool validateBracketsFile(const string& path, int threads) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("validateBracketsFile: cannot open " + path);
+    }
+    try {
+        bool balanced = validateBracketsFd(fd, threads);
+        close(fd);
+        return balanced;
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+}
+
+/*
+Time Complexity: O(n / W + b) for n bytes with b brackets (W = 32 or 16
+bytes per SIMD block), divided by the number of threads, plus O(s) to
+combine summaries of total size s.
+Space Complexity: O(d) per thread for nesting depth d, plus one block for
+inputs that are read rather than mapped; independent of n.
+Notes:
+Brackets inside JSON strings ("a(b") are counted like any other, as in
+areBracketsBalanced; a JSON-aware validator would also track quotes.
+*/
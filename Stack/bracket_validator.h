@@ -0,0 +1,53 @@
+// bracket_validator.h
+#ifndef BRACKET_VALIDATOR_H
+#define BRACKET_VALIDATOR_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+Bracket validation for large inputs
+===================================
+The same check as areBracketsBalanced (Stack_usage_example/
+Bracket_delimiters_checking.cpp): every ( [ { is closed by the matching
+) ] } in the right order. Other bytes are ignored. Built for inputs of
+gigabytes (JSON-like payloads):
+- bytes that are not brackets are skipped 32 (AVX2) or 16 (SSE2) at a time
+- a file descriptor is read in fixed-size blocks (or mapped, when it is a
+  regular file), so memory does not grow with the input: only with the
+  nesting depth (one byte per open bracket)
+- the input can be split across threads; each thread reduces its chunk to
+  a BracketSummary and the summaries are combined in order
+
+    bool ok = validateBrackets(text.data(), text.size());
+    bool ok = parallelValidateBrackets(data, n);       // all hardware threads
+    bool ok = validateBracketsFd(fd);                  // file, pipe or socket
+*/
+
+// What is left of a chunk once the brackets that match inside it are removed:
+// closing brackets that match something before the chunk, followed by
+// opening brackets that are closed after it.
+struct BracketSummary {
+    std::string closers; // in input order: closers[0] must match the innermost opener before the chunk
+    std::string openers; // in input order: openers.back() is the innermost one
+    bool mismatch = false; // a closing bracket met an opening bracket of another type
+};
+
+// Adds the brackets of data[0..n) to summary (summary describes what came before)
+void scanBrackets(const char data[], std::size_t n, BracketSummary& summary);
+
+// Combines the summaries of consecutive chunks; true when the whole input is balanced
+bool combineBracketSummaries(const std::vector<BracketSummary>& parts);
+
+bool validateBrackets(const char data[], std::size_t n);
+bool parallelValidateBrackets(const char data[], std::size_t n, int threads = 0); // threads = 0: all hardware threads
+// Checks the input from the current offset of fd to its end. Regular files are mapped and split
+// across threads, and the offset is left at the end of the file; other descriptors are read up to
+// the first error found (the offset of a pipe or socket cannot be moved back)
+bool validateBracketsFd(int fd, int threads = 0);
+bool validateBracketsFile(const std::string& path, int threads = 0);
+
+const char* bracketKernelName(); // "avx2", "sse2" or "scalar"
+
+#endif
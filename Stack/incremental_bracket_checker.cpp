@@ -0,0 +1,834 @@
+/*
+Incremental bracket checking (see incremental_bracket_checker.h)
+
+Running sum:
+Number the brackets 0, 1, 2, ... (their rank) and let e(i) be the sum of
++1 (opener) / -1 (closer) over ranks 0..i, with e(-1) = 0 (empty prefix).
+Ignoring bracket types, the text is balanced when e ends at 0 and is never
+negative, and the partners follow from e alone:
+- the partner of the opener i is the first closer k > i with e(k) = e(i - 1)
+- the partner of the closer k is j + 1 for the last j < k with e(j) <= e(k)
+  (none when there is no such j: the closer has no opener)
+With the minimum prefix sum of every subtree, "the first rank >= from (or
+the last rank < to) where the sum is <= L" is one descent of the tree.
+
+Bracket types:
+Once the pairs inside it are removed, any run of brackets reduces to its
+unmatched closers followed by its unmatched openers: ")]...}" + "{(...[".
+Their numbers follow from excess and minPrefix; every subtree also stores
+the types of both sequences as polynomial hashes (mod 2^61 - 1, base B
+drawn once per process), closers with the first one at B^0 and openers
+with the innermost one at B^0, plus a flag `bad` when two brackets of the
+subtree pair up with different types. Joining a left part to a right
+part pairs the innermost openers of the left part with the first closers
+of the right part, j = min(openers, closers) of them. In both hashes the
+pair at distance i from the junction is at B^i, so all j pairs are
+compared at once: the low j digits of the opener hash against the first
+j closers of the right part.
+The first m openers or closers of a subtree are one descent: every node
+keeps, for the junction between its left part (left subtree and its own
+bracket) and its right subtree, the hash of the openers of the left part
+that stay open and the hash of the closers of the right subtree that are
+used up. update therefore costs O(log n) and an edit O(log^2 n), whatever
+the nesting depth. A hash collision can hide a mismatch, with probability
+about n / 2^61 per compared pair of sequences.
+*/
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "bracket_chars.h"
+#include "incremental_bracket_checker.h"
+
+using namespace std;
+
+struct BracketTreeNode {
+    char bracket;
+    unsigned priority;
+    long long gap; // characters between the previous bracket and this one
+    BracketTreeNode* left = nullptr;
+    BracketTreeNode* right = nullptr;
+
+    // Summary of the subtree
+    long long chars; // characters, gaps included
+    int count; // brackets
+    int excess; // openers minus closers
+    int minPrefix; // smallest running sum over the brackets of the subtree
+
+    // Types of the unmatched brackets of the subtree (hashes mod 2^61 - 1)
+    bool bad; // a pair of brackets of different types
+    unsigned long long openHash; // unmatched openers, the innermost one at B^0
+    unsigned long long openPow; // B^(unmatched openers)
+    unsigned long long closeHash; // unmatched closers, the first one at B^0
+    unsigned long long closePow; // B^(unmatched closers)
+
+    // Junction of the left part (left subtree and this bracket) with the right
+    // subtree, whose first `joined` unmatched closers close openers of the left part
+    unsigned long long keptHash; // openers of the left part that stay open
+    unsigned long long keptPow;
+    unsigned long long joinedHash; // the first `joined` unmatched closers of the right subtree
+    unsigned long long closeShift; // B^(closers of the left part - joined)
+
+    BracketTreeNode(char bracket, unsigned priority, long long gap) : bracket(bracket), priority(priority), gap(gap) {}
+};
+
+namespace {
+typedef BracketTreeNode Node;
+
+// A hash and B^(length of the hashed sequence)
+struct HashPart {
+    unsigned long long hash;
+    unsigned long long pow;
+};
+
+// Unmatched bracket counts around the junction of a node
+struct Junction {
+    int leftOpen, leftClose; // left subtree
+    int partOpen, partClose; // left part: left subtree and the node's bracket
+    int joined; // closers of the right subtree that close openers of the left part
+    int kept; // openers of the left part still open after the right subtree
+};
+
+struct HashBase {
+    unsigned long long base;
+    unsigned long long inverse;
+};
+}
+
+static inline int valueOf(const Node* node) { return isOpeningBracket(node->bracket) ? 1 : -1; }
+static inline int countOf(const Node* node) { return node ? node->count : 0; }
+static inline long long charsOf(const Node* node) { return node ? node->chars : 0; }
+static inline int excessOf(const Node* node) { return node ? node->excess : 0; }
+static inline int closersOf(const Node* node) { return node ? max(0, -node->minPrefix) : 0; }
+static inline int openersOf(const Node* node) { return node ? node->excess + closersOf(node) : 0; }
+static inline bool badOf(const Node* node) { return node && node->bad; }
+static inline HashPart openersHashOf(const Node* node) { return node ? HashPart{node->openHash, node->openPow} : HashPart{0, 1}; }
+static inline HashPart closersHashOf(const Node* node) { return node ? HashPart{node->closeHash, node->closePow} : HashPart{0, 1}; }
+
+// ( [ { and their closers hash as the opener's character
+static inline unsigned long long typeOf(char bracket) {
+    return static_cast<unsigned char>(isOpeningBracket(bracket) ? bracket : openingBracketOf(bracket));
+}
+
+/////////////////////////////////////////////////////////////////
+// Arithmetic mod 2^61 - 1
+const unsigned long long hashModulus = (1ULL << 61) - 1;
+
+static inline unsigned long long addMod(unsigned long long a, unsigned long long b) {
+    unsigned long long sum = a + b;
+    return sum >= hashModulus ? sum - hashModulus : sum;
+}
+
+static inline unsigned long long subMod(unsigned long long a, unsigned long long b) {
+    return a >= b ? a - b : a + hashModulus - b;
+}
+
+static inline unsigned long long mulMod(unsigned long long a, unsigned long long b) {
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    unsigned long long sum = static_cast<unsigned long long>(product & hashModulus) + static_cast<unsigned long long>(product >> 61);
+    return sum >= hashModulus ? sum - hashModulus : sum;
+}
+
+static unsigned long long powMod(unsigned long long base, unsigned long long exponent) {
+    unsigned long long result = 1;
+    while (exponent > 0) {
+        if (exponent & 1) {
+            result = mulMod(result, base);
+        }
+        base = mulMod(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+static const HashBase& hashBase() {
+    static const HashBase value = [] {
+        random_device device;
+        mt19937_64 generator((static_cast<unsigned long long>(device()) << 32) ^ device());
+        unsigned long long base = 256 + generator() % (hashModulus - 512);
+        return HashBase{base, powMod(base, hashModulus - 2)};
+    }();
+    return value;
+}
+
+// Openers: `first` comes before `second`, which holds the innermost ones
+static inline HashPart appendOpeners(HashPart first, HashPart second) {
+    return {addMod(mulMod(first.hash, second.pow), second.hash), mulMod(first.pow, second.pow)};
+}
+
+// Closers: `first` comes before `second`, the first closer stays at B^0
+static inline HashPart appendClosers(HashPart first, HashPart second) {
+    return {addMod(first.hash, mulMod(first.pow, second.hash)), mulMod(first.pow, second.pow)};
+}
+
+/////////////////////////////////////////////////////////////////
+// Typed summaries
+
+static Junction junctionOf(const Node* node) {
+    Junction junction;
+    junction.leftOpen = openersOf(node->left);
+    junction.leftClose = closersOf(node->left);
+    junction.partOpen = junction.leftOpen;
+    junction.partClose = junction.leftClose;
+    if (isOpeningBracket(node->bracket)) {
+        junction.partOpen++;
+    } else if (junction.leftOpen > 0) {
+        junction.partOpen--;
+    } else {
+        junction.partClose++;
+    }
+    junction.joined = min(junction.partOpen, closersOf(node->right));
+    junction.kept = junction.partOpen - junction.joined;
+    return junction;
+}
+
+// Hash of the first m unmatched openers of the subtree
+static HashPart openerPrefix(const Node* node, int m) {
+    HashPart result{0, 1};
+    while (m > 0) {
+        if (m == openersOf(node)) {
+            return appendOpeners(result, openersHashOf(node));
+        }
+        Junction junction = junctionOf(node);
+        if (m == junction.kept) {
+            return appendOpeners(result, {node->keptHash, node->keptPow});
+        }
+        if (m < junction.kept) {
+            node = node->left; // the kept openers start with those of the left subtree
+        } else {
+            result = appendOpeners(result, {node->keptHash, node->keptPow});
+            m -= junction.kept;
+            node = node->right;
+        }
+    }
+    return result;
+}
+
+// Hash of the first m unmatched closers of the subtree
+static HashPart closerPrefix(const Node* node, int m) {
+    HashPart result{0, 1};
+    while (m > 0) {
+        if (m == closersOf(node)) {
+            return appendClosers(result, closersHashOf(node));
+        }
+        Junction junction = junctionOf(node);
+        if (m <= junction.leftClose) {
+            node = node->left;
+            continue;
+        }
+        HashPart part = closersHashOf(node->left);
+        if (junction.partClose > junction.leftClose) {
+            part = appendClosers(part, {typeOf(node->bracket), hashBase().base});
+        }
+        if (m == junction.partClose) {
+            return appendClosers(result, part);
+        }
+        // Closers joined..joined + rest of the right subtree come after the left part:
+        // their hash is (prefix - joinedHash) * B^-joined, shifted by the left part
+        unsigned long long shift = mulMod(result.pow, node->closeShift);
+        result.hash = subMod(addMod(result.hash, mulMod(result.pow, part.hash)), mulMod(shift, node->joinedHash));
+        result.pow = shift;
+        m = m - junction.partClose + junction.joined;
+        node = node->right;
+    }
+    return result;
+}
+
+/////////////////////////////////////////////////////////////////
+// Treap ordered by rank
+static void update(Node* node) {
+    node->count = countOf(node->left) + 1 + countOf(node->right);
+    node->chars = charsOf(node->left) + node->gap + 1 + charsOf(node->right);
+    int self = excessOf(node->left) + valueOf(node);
+    node->excess = self + excessOf(node->right);
+    node->minPrefix = self;
+    if (node->left) {
+        node->minPrefix = min(node->minPrefix, node->left->minPrefix);
+    }
+    if (node->right) {
+        node->minPrefix = min(node->minPrefix, self + node->right->minPrefix);
+    }
+
+    // The left part: the bracket is added to the left subtree
+    const HashBase& hash = hashBase();
+    Junction junction = junctionOf(node);
+    unsigned long long type = typeOf(node->bracket);
+    bool bad = badOf(node->left) || badOf(node->right);
+    HashPart partOpen = openersHashOf(node->left);
+    HashPart partClose = closersHashOf(node->left);
+    if (isOpeningBracket(node->bracket)) {
+        partOpen = appendOpeners(partOpen, {type, hash.base});
+    } else if (junction.leftOpen > 0) {
+        HashPart below = openerPrefix(node->left, junction.leftOpen - 1);
+        bad |= partOpen.hash != addMod(mulMod(below.hash, hash.base), type);
+        partOpen = below;
+    } else {
+        partClose = appendClosers(partClose, {type, hash.base});
+    }
+
+    // The right subtree closes the innermost `joined` openers of the left part
+    HashPart kept = partOpen;
+    HashPart joined{0, 1};
+    node->closeShift = partClose.pow;
+    if (junction.joined > 0) {
+        kept = openerPrefix(node->left, junction.kept);
+        joined = closerPrefix(node->right, junction.joined);
+        bad |= subMod(partOpen.hash, mulMod(kept.hash, joined.pow)) != joined.hash;
+        node->closeShift = mulMod(partClose.pow, powMod(hash.inverse, junction.joined));
+    }
+    node->keptHash = kept.hash;
+    node->keptPow = kept.pow;
+    node->joinedHash = joined.hash;
+    node->bad = bad;
+
+    HashPart rightOpen = openersHashOf(node->right);
+    HashPart rightClose = closersHashOf(node->right);
+    node->openHash = addMod(mulMod(kept.hash, rightOpen.pow), rightOpen.hash);
+    node->openPow = mulMod(kept.pow, rightOpen.pow);
+    node->closeHash = addMod(partClose.hash, mulMod(subMod(rightClose.hash, joined.hash), node->closeShift));
+    node->closePow = mulMod(node->closeShift, rightClose.pow);
+}
+
+// left gets the first `rank` brackets, right the others
+static void split(Node* node, int rank, Node*& left, Node*& right) {
+    if (!node) {
+        left = right = nullptr;
+        return;
+    }
+    if (countOf(node->left) < rank) {
+        split(node->right, rank - countOf(node->left) - 1, node->right, right);
+        left = node;
+    } else {
+        split(node->left, rank, left, node->left);
+        right = node;
+    }
+    update(node);
+}
+
+static Node* merge(Node* left, Node* right) {
+    if (!left || !right) {
+        return left ? left : right;
+    }
+    if (left->priority > right->priority) {
+        left->right = merge(left->right, right);
+        update(left);
+        return left;
+    }
+    right->left = merge(left, right->left);
+    update(right);
+    return right;
+}
+
+static void updateAll(Node* node) {
+    if (node) {
+        updateAll(node->left);
+        updateAll(node->right);
+        update(node);
+    }
+}
+
+// Treap of nodes given in rank order: the right spine is kept on a stack
+static Node* build(const vector<Node*>& nodes) {
+    vector<Node*> spine;
+    for (Node* node : nodes) {
+        Node* last = nullptr;
+        while (!spine.empty() && spine.back()->priority < node->priority) {
+            last = spine.back();
+            spine.pop_back();
+        }
+        node->left = last;
+        if (!spine.empty()) {
+            spine.back()->right = node;
+        }
+        spine.push_back(node);
+    }
+    Node* root = spine.empty() ? nullptr : spine.front();
+    updateAll(root);
+    return root;
+}
+
+static void destroy(Node* node) {
+    if (node) {
+        destroy(node->left);
+        destroy(node->right);
+        delete node;
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// Searches over the running sum (ranks are local to the subtree, base is
+// the sum before it; -1 when there is no such rank)
+
+// First rank whose running sum is <= target
+static int firstAtMost(const Node* node, int base, int target) {
+    if (!node || base + node->minPrefix > target) {
+        return -1;
+    }
+    int found = firstAtMost(node->left, base, target);
+    if (found >= 0) {
+        return found;
+    }
+    int self = base + excessOf(node->left) + valueOf(node);
+    if (self <= target) {
+        return countOf(node->left);
+    }
+    return countOf(node->left) + 1 + firstAtMost(node->right, self, target);
+}
+
+// First rank >= from whose running sum is <= target
+static int firstAtMostFrom(const Node* node, int base, int from, int target) {
+    if (!node) {
+        return -1;
+    }
+    if (from <= 0) {
+        return firstAtMost(node, base, target);
+    }
+    int leftCount = countOf(node->left);
+    int self = base + excessOf(node->left) + valueOf(node);
+    if (from <= leftCount) {
+        int found = firstAtMostFrom(node->left, base, from, target);
+        if (found >= 0) {
+            return found;
+        }
+        if (self <= target) {
+            return leftCount;
+        }
+        found = firstAtMost(node->right, self, target);
+        return found < 0 ? -1 : leftCount + 1 + found;
+    }
+    int found = firstAtMostFrom(node->right, self, from - leftCount - 1, target);
+    return found < 0 ? -1 : leftCount + 1 + found;
+}
+
+// Last rank whose running sum is <= target
+static int lastAtMost(const Node* node, int base, int target) {
+    if (!node || base + node->minPrefix > target) {
+        return -1;
+    }
+    int self = base + excessOf(node->left) + valueOf(node);
+    int found = lastAtMost(node->right, self, target);
+    if (found >= 0) {
+        return countOf(node->left) + 1 + found;
+    }
+    if (self <= target) {
+        return countOf(node->left);
+    }
+    return lastAtMost(node->left, base, target);
+}
+
+// Last rank < to whose running sum is <= target
+static int lastAtMostBefore(const Node* node, int base, int to, int target) {
+    if (!node || to <= 0) {
+        return -1;
+    }
+    if (to >= node->count) {
+        return lastAtMost(node, base, target);
+    }
+    int leftCount = countOf(node->left);
+    if (to > leftCount) {
+        int self = base + excessOf(node->left) + valueOf(node);
+        int found = lastAtMostBefore(node->right, self, to - leftCount - 1, target);
+        if (found >= 0) {
+            return leftCount + 1 + found;
+        }
+        if (self <= target) {
+            return leftCount;
+        }
+        return lastAtMost(node->left, base, target);
+    }
+    return lastAtMostBefore(node->left, base, to, target);
+}
+
+/////////////////////////////////////////////////////////////////
+// First pair of different types
+
+/*
+The open brackets of a prefix of the text, as runs: the first `kept`
+unmatched openers of a subtree, or a single opener (subtree == nullptr).
+The prefix grows while the tree is walked from the root, by at most two
+runs per level.
+*/
+namespace {
+struct OpenerRun {
+    const Node* subtree;
+    char bracket;
+    int kept;
+    HashPart hash; // the kept openers
+    int before; // openers of the runs below
+    unsigned long long beforeHash;
+};
+}
+
+static HashPart runPrefix(const OpenerRun& run, int m) {
+    if (!run.subtree) {
+        return m > 0 ? HashPart{typeOf(run.bracket), hashBase().base} : HashPart{0, 1};
+    }
+    return openerPrefix(run.subtree, m);
+}
+
+static int openCount(const vector<OpenerRun>& runs) {
+    return runs.empty() ? 0 : runs.back().before + runs.back().kept;
+}
+
+static unsigned long long openHashOf(const vector<OpenerRun>& runs) {
+    if (runs.empty()) {
+        return 0;
+    }
+    const OpenerRun& top = runs.back();
+    return addMod(mulMod(top.beforeHash, top.hash.pow), top.hash.hash);
+}
+
+// Hash of the first m open brackets of the runs
+static unsigned long long openPrefixHash(const vector<OpenerRun>& runs, int m) {
+    size_t i = runs.size();
+    while (i > 0 && runs[i - 1].before >= m) {
+        i--;
+    }
+    if (i == 0) {
+        return 0;
+    }
+    const OpenerRun& run = runs[i - 1];
+    HashPart part = runPrefix(run, m - run.before);
+    return addMod(mulMod(run.beforeHash, part.pow), part.hash);
+}
+
+// True when the first unmatched closers of the subtree close open brackets of
+// the runs of other types
+static bool closesWrongly(const vector<OpenerRun>& runs, const Node* node) {
+    int open = openCount(runs);
+    int joined = min(open, closersOf(node));
+    if (joined == 0) {
+        return false;
+    }
+    HashPart closers = closerPrefix(node, joined);
+    unsigned long long inner = subMod(openHashOf(runs), mulMod(openPrefixHash(runs, open - joined), closers.pow));
+    return inner != closers.hash;
+}
+
+static void pushRun(vector<OpenerRun>& runs, const Node* subtree, char bracket, int kept, HashPart hash) {
+    OpenerRun run{subtree, bracket, kept, hash, 0, 0};
+    if (!runs.empty()) {
+        const OpenerRun& top = runs.back();
+        run.before = top.before + top.kept;
+        run.beforeHash = addMod(mulMod(top.beforeHash, top.hash.pow), top.hash.hash);
+    }
+    runs.push_back(run);
+}
+
+// The runs followed by the brackets of the subtree
+static void appendSubtree(vector<OpenerRun>& runs, const Node* node) {
+    int closers = closersOf(node);
+    while (closers > 0 && !runs.empty()) {
+        OpenerRun& top = runs.back();
+        if (top.kept <= closers) {
+            closers -= top.kept;
+            runs.pop_back();
+        } else {
+            top.kept -= closers;
+            top.hash = runPrefix(top, top.kept);
+            closers = 0;
+        }
+    }
+    if (openersOf(node) > 0) {
+        pushRun(runs, node, 0, openersOf(node), openersHashOf(node));
+    }
+}
+
+// Rank of the first closer that pairs with an opener of another type,
+// -1 when there is none
+static int firstWrongPair(const Node* root) {
+    if (!badOf(root)) {
+        return -1;
+    }
+    // Invariant: the runs followed by the subtree contain such a pair
+    vector<OpenerRun> runs;
+    const Node* node = root;
+    int rank = 0;
+    while (node) {
+        if (node->left && (node->left->bad || closesWrongly(runs, node->left))) {
+            node = node->left;
+            continue;
+        }
+        appendSubtree(runs, node->left);
+        rank += countOf(node->left);
+        if (isOpeningBracket(node->bracket)) {
+            pushRun(runs, nullptr, node->bracket, 1, {typeOf(node->bracket), hashBase().base});
+        } else if (!runs.empty()) {
+            unsigned long long below = openPrefixHash(runs, openCount(runs) - 1);
+            if (subMod(openHashOf(runs), mulMod(below, hashBase().base)) != typeOf(node->bracket)) {
+                return rank;
+            }
+            OpenerRun& top = runs.back();
+            if (--top.kept == 0) {
+                runs.pop_back();
+            } else {
+                top.hash = runPrefix(top, top.kept);
+            }
+        }
+        rank++;
+        node = node->right;
+    }
+    return -1; // only reached on a hash collision
+}
+
+/////////////////////////////////////////////////////////////////
+// Helpers of IncrementalBracketChecker
+
+// The opener (rank < before) that raises the sum from level to level + 1 for
+// the last time before `before`: the partner of a closer at rank >= before that
+// brings the sum back to level. -1 when the sum never was at level.
+int IncrementalBracketChecker::openerOfLevel(int before, int level) const {
+    int last = lastAtMostBefore(root, 0, before, level);
+    if (last < 0 && level < 0) {
+        return -1; // the empty prefix (sum 0) does not count either
+    }
+    return last + 1;
+}
+
+// Sum and smallest running sum (0 for the empty prefix included) of the ranks < rank
+void IncrementalBracketChecker::prefixSummary(int rank, int& excess, int& minimum) const {
+    int base = 0;
+    minimum = 0;
+    const Node* node = root;
+    while (node && rank > 0) {
+        int leftCount = countOf(node->left);
+        if (rank <= leftCount) {
+            node = node->left;
+            continue;
+        }
+        if (node->left) {
+            minimum = min(minimum, base + node->left->minPrefix);
+        }
+        base += excessOf(node->left) + valueOf(node);
+        minimum = min(minimum, base);
+        rank -= leftCount + 1;
+        node = node->right;
+    }
+    excess = base;
+}
+
+Node* IncrementalBracketChecker::nodeAt(int rank) const {
+    Node* node = root;
+    while (node) {
+        int leftCount = countOf(node->left);
+        if (rank == leftCount) {
+            return node;
+        }
+        if (rank < leftCount) {
+            node = node->left;
+        } else {
+            rank -= leftCount + 1;
+            node = node->right;
+        }
+    }
+    throw out_of_range("IncrementalBracketChecker: bracket rank out of range");
+}
+
+long long IncrementalBracketChecker::positionOf(int rank) const {
+    long long pos = 0;
+    const Node* node = root;
+    while (node) {
+        int leftCount = countOf(node->left);
+        if (rank < leftCount) {
+            node = node->left;
+            continue;
+        }
+        pos += charsOf(node->left) + node->gap;
+        if (rank == leftCount) {
+            return pos;
+        }
+        pos++;
+        rank -= leftCount + 1;
+        node = node->right;
+    }
+    throw out_of_range("IncrementalBracketChecker: bracket rank out of range");
+}
+
+// The first bracket at a position >= pos: its rank and position
+// (bracketCount() and length() when there is none)
+void IncrementalBracketChecker::locate(long long pos, int& rank, long long& bracketPos) const {
+    rank = bracketCount();
+    bracketPos = length();
+    int before = 0; // brackets before the subtree
+    long long start = 0; // position of the subtree
+    const Node* node = root;
+    while (node) {
+        long long nodePos = start + charsOf(node->left) + node->gap;
+        if (pos <= nodePos) {
+            rank = before + countOf(node->left);
+            bracketPos = nodePos;
+            node = node->left;
+        } else {
+            before += countOf(node->left) + 1;
+            start = nodePos + 1;
+            node = node->right;
+        }
+    }
+}
+
+// Characters between the bracket before rank (or the start) and the one at rank,
+// the text after the last bracket when rank == bracketCount()
+void IncrementalBracketChecker::setGap(int rank, long long gap) {
+    if (rank == bracketCount()) {
+        trailingGap = gap;
+        return;
+    }
+    // Only the lengths on the path change, the bracket summaries do not
+    long long delta = gap - nodeAt(rank)->gap;
+    Node* node = root;
+    while (true) {
+        node->chars += delta;
+        int leftCount = countOf(node->left);
+        if (rank == leftCount) {
+            node->gap = gap;
+            return;
+        }
+        if (rank < leftCount) {
+            node = node->left;
+        } else {
+            rank -= leftCount + 1;
+            node = node->right;
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////
+// Public interface
+IncrementalBracketChecker::IncrementalBracketChecker() : random(0x9E3779B9u) {}
+
+IncrementalBracketChecker::IncrementalBracketChecker(const string& text) : random(0x9E3779B9u) {
+    insert(0, text);
+}
+
+IncrementalBracketChecker::~IncrementalBracketChecker() {
+    destroy(root);
+}
+
+// The brackets of text become a treap of their own, merged in at one point
+void IncrementalBracketChecker::insert(long long pos, const string& text) {
+    if (pos < 0 || pos > length()) {
+        throw out_of_range("IncrementalBracketChecker::insert: position out of range");
+    }
+    int rank;
+    long long bracketPos;
+    locate(pos, rank, bracketPos);
+    long long gapStart = bracketPos - (rank == bracketCount() ? trailingGap : nodeAt(rank)->gap);
+
+    vector<Node*> nodes;
+    long long gap = pos - gapStart;
+    for (char c : text) {
+        if (isBracketChar(c)) {
+            nodes.push_back(new Node(c, random(), gap));
+            gap = 0;
+        } else {
+            gap++;
+        }
+    }
+    setGap(rank, gap + bracketPos - pos);
+    if (nodes.empty()) {
+        return;
+    }
+    Node* left;
+    Node* right;
+    split(root, rank, left, right);
+    root = merge(merge(left, build(nodes)), right);
+}
+
+void IncrementalBracketChecker::erase(long long pos, long long count) {
+    if (pos < 0 || count < 0 || pos + count > length()) {
+        throw out_of_range("IncrementalBracketChecker::erase: range out of range");
+    }
+    int first, end;
+    long long firstPos, endPos;
+    locate(pos, first, firstPos);
+    locate(pos + count, end, endPos);
+    long long gapStart = firstPos - (first == bracketCount() ? trailingGap : nodeAt(first)->gap);
+
+    // The brackets in [pos, pos + count) are ranks first..end - 1
+    if (first == end) {
+        setGap(first, endPos - count - gapStart);
+        return;
+    }
+    Node* left;
+    Node* middle;
+    Node* right;
+    split(root, first, left, right);
+    split(right, end - first, middle, right);
+    destroy(middle);
+    root = merge(left, right);
+    setGap(first, endPos - count - gapStart);
+}
+
+long long IncrementalBracketChecker::length() const {
+    return charsOf(root) + trailingGap;
+}
+
+int IncrementalBracketChecker::bracketCount() const {
+    return countOf(root);
+}
+
+bool IncrementalBracketChecker::isBalanced() const {
+    return !root || (root->excess == 0 && root->minPrefix >= 0 && !root->bad);
+}
+
+/*
+The position where areBracketsBalanced would fail: the first closer without
+an opener or with an opener of another type; when every closer is fine but
+brackets stay open, the first of those openers.
+*/
+long long IncrementalBracketChecker::firstMismatch() const {
+    if (isBalanced()) {
+        return -1;
+    }
+    int unmatched = firstAtMost(root, 0, -1);
+    int mismatched = firstWrongPair(root);
+    int rank;
+    if (unmatched >= 0 && mismatched >= 0) {
+        rank = min(unmatched, mismatched);
+    } else if (unmatched >= 0 || mismatched >= 0) {
+        rank = max(unmatched, mismatched);
+    } else {
+        rank = openerOfLevel(bracketCount(), 0);
+    }
+    return positionOf(rank);
+}
+
+/*
+The partner by nesting: for an opener, the closer that brings the count of
+open brackets back to what it was before it, and the other way round. Its
+type may differ (firstMismatch reports that).
+*/
+long long IncrementalBracketChecker::matchOf(long long pos) const {
+    int rank;
+    long long bracketPos;
+    locate(pos, rank, bracketPos);
+    if (pos < 0 || bracketPos != pos || rank == bracketCount()) {
+        return -1;
+    }
+    int excess, minimum;
+    prefixSummary(rank, excess, minimum);
+    int partner;
+    if (isOpeningBracket(nodeAt(rank)->bracket)) {
+        partner = firstAtMostFrom(root, 0, rank + 1, excess);
+    } else {
+        partner = openerOfLevel(rank, excess - 1);
+    }
+    return partner < 0 ? -1 : positionOf(partner);
+}
+
+/*
+Time Complexity (n brackets, expected, the treap has depth O(log n)):
+- isBalanced: O(1)
+- matchOf: O(log n)
+- firstMismatch: O(log^2 n)
+- insert of k characters: O(log^2 n + k log k), erase: O(log^2 n + k),
+  at any nesting depth
+Space Complexity: O(n) for the brackets; other characters are only counted.
+Notes:
+update combines two typed summaries with at most three descents of
+O(log n); a split or merge updates the O(log n) nodes of one path.
+Inserted text is built into a treap of its own (its shape in O(k), its
+summaries in O(k log k)) and merged in, and an erased range is split
+off, so a paste or a deletion costs one edit plus its own brackets.
+*/
@@ -0,0 +1,70 @@
+// incremental_bracket_checker.h
+#ifndef INCREMENTAL_BRACKET_CHECKER_H
+#define INCREMENTAL_BRACKET_CHECKER_H
+
+#include <random>
+#include <string>
+
+/*
+Incremental bracket checking
+============================
+areBracketsBalanced rescans the whole text, O(n), after every edit. This
+checker follows the edits of a document (insert / erase at a character
+position) and answers after each one:
+- isBalanced(): same result as areBracketsBalanced on the current text
+- firstMismatch(): position where the check fails
+- matchOf(pos): the bracket that closes / opens the one at pos
+
+It keeps only the brackets, in a balanced binary tree (a treap, ordered by
+position) where every bracket also records how many other characters come
+before it. Every subtree stores a summary of its brackets, with ( [ { as
++1 and ) ] } as -1:
+- excess: the sum (open minus closed brackets)
+- minPrefix: the smallest running sum over its prefixes
+- the length in characters, the number of brackets
+- the types of its unmatched closers and unmatched openers, as hashes, and
+  whether two of its brackets pair up with different types
+From the summaries, "is there a running sum <= L after / before position
+p" is answered by descending the tree, which finds the partner of a bracket
+and the first closer without one in O(log n). Two summaries combine in
+O(log n) whatever the nesting depth, so an edit costs O(log^2 n).
+
+    IncrementalBracketChecker checker(document);
+    checker.insert(120, "[x]");
+    checker.erase(40, 1);
+    if (!checker.isBalanced()) highlight(checker.firstMismatch());
+*/
+struct BracketTreeNode; // a bracket and the summary of its subtree (incremental_bracket_checker.cpp)
+
+class IncrementalBracketChecker {
+private:
+    BracketTreeNode* root = nullptr;
+    long long trailingGap = 0; // characters after the last bracket
+    std::mt19937 random;
+
+    // Brackets are addressed by rank (0 = first bracket of the text)
+    int openerOfLevel(int before, int level) const;
+    void prefixSummary(int rank, int& excess, int& minimum) const;
+    BracketTreeNode* nodeAt(int rank) const;
+    long long positionOf(int rank) const;
+    void locate(long long pos, int& rank, long long& bracketPos) const;
+    void setGap(int rank, long long gap);
+
+public:
+    IncrementalBracketChecker();
+    explicit IncrementalBracketChecker(const std::string& text);
+    IncrementalBracketChecker(const IncrementalBracketChecker&) = delete;
+    IncrementalBracketChecker& operator=(const IncrementalBracketChecker&) = delete;
+    ~IncrementalBracketChecker();
+
+    void insert(long long pos, const std::string& text); // text goes before the character at pos
+    void erase(long long pos, long long count);
+    long long length() const;
+    int bracketCount() const;
+
+    bool isBalanced() const;
+    long long firstMismatch() const; // -1 when balanced
+    long long matchOf(long long pos) const; // -1 when pos has no partner (or is not a bracket)
+};
+
+#endif
@@ -0,0 +1,370 @@
+// lock_free_stack.h
+#ifndef LOCK_FREE_STACK_H
+#define LOCK_FREE_STACK_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/*
+Lock-free stack (Treiber stack)
+===============================
+Stack (stack.h) is not thread-safe, and a Stack behind a mutex lets one
+thread in at a time. LockFreeStack<T> is a linked list whose top is one
+atomic pointer; push and pop swing it with compare-and-swap (CAS), so any
+number of threads can push and pop at once and a thread that is preempted
+never blocks the others.
+
+    push: node->next = top; CAS(top, node->next, node), retry on failure
+    pop:  t = top; CAS(top, t, t->next), retry on failure
+
+Two problems of the naive version, and how they are solved here:
+- Use after free: a popping thread reads t->next while another thread may
+  already have popped and deleted t. Hazard pointers: before touching t a
+  thread publishes it in its hazard slot, and a popped node is only
+  deleted once no slot holds it (retireNode/scanHazards below).
+- ABA: between reading t and the CAS, t may be popped, deleted, and a new
+  node allocated at the same address pushed, so the CAS succeeds with a
+  stale t->next. A node cannot be deleted (hence not reallocated) while it
+  is protected by a hazard pointer, so this cannot happen either.
+
+Elimination backoff: when a CAS on top fails (contention), a push and a
+pop that are running at the same time cancel out without touching top: the
+pusher offers its node in a random slot of a small exchange array, and a
+pop that finds it there takes it. Under high contention most operations
+then complete in the array instead of retrying on the single top pointer.
+
+    LockFreeStack<Task*> pool;
+    pool.push(task);                      // any thread
+    Task* next;
+    if (pool.tryPop(next)) { ... }        // any thread
+*/
+
+/////////////////////////////////////////////////////////////////
+// hazard pointers
+// One record per thread (reused after the thread exits). The record holds
+// the pointer the thread is about to dereference and the nodes it popped
+// but could not delete yet.
+struct RetiredNode {
+    void* pointer;
+    void (*reclaim)(void*);
+};
+
+struct HazardRecord {
+    std::atomic<const void*> hazard{nullptr};
+    std::atomic<bool> active{false};
+    HazardRecord* next = nullptr;
+    std::vector<RetiredNode> retired; // only used by the thread that holds the record
+};
+
+// All records ever created; they are freed (with the nodes still retired) at exit
+struct HazardRecordList {
+    std::atomic<HazardRecord*> head{nullptr};
+    std::atomic<int> size{0};
+
+    ~HazardRecordList() {
+        HazardRecord* record = head.load();
+        while (record != nullptr) {
+            HazardRecord* next = record->next;
+            for (const RetiredNode& node : record->retired) {
+                node.reclaim(node.pointer);
+            }
+            delete record;
+            record = next;
+        }
+    }
+};
+
+inline HazardRecordList hazardRecords;
+
+// A thread deletes its retired nodes once it has this many (plus 2 per record)
+const std::size_t hazardScanThreshold = 64;
+
+// Deletes the retired nodes of record that no thread is protecting
+inline void scanHazards(HazardRecord& record) {
+    // Pairs with the seq_cst hazard store and re-check of top in popNode. A node is
+    // retired only after it was unlinked; without a full fence between the unlink and
+    // the hazard loads below (store buffering), on ARM/POWER the scan could still read
+    // a null hazard while the reader reads the old top, and free the node under it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<const void*> protectedNodes;
+    for (HazardRecord* r = hazardRecords.head.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+        const void* p = r->hazard.load(std::memory_order_seq_cst);
+        if (p != nullptr) {
+            protectedNodes.push_back(p);
+        }
+    }
+    std::sort(protectedNodes.begin(), protectedNodes.end());
+    std::size_t kept = 0;
+    for (RetiredNode node : record.retired) {
+        if (std::binary_search(protectedNodes.begin(), protectedNodes.end(), node.pointer)) {
+            record.retired[kept++] = node;
+        } else {
+            node.reclaim(node.pointer);
+        }
+    }
+    record.retired.resize(kept);
+}
+
+// The calling thread's record: acquired on first use, released when the thread exits
+struct HazardThread {
+    HazardRecord* record = nullptr;
+
+    HazardRecord& get() {
+        if (record == nullptr) {
+            record = acquire();
+        }
+        return *record;
+    }
+
+    static HazardRecord* acquire() {
+        for (HazardRecord* r = hazardRecords.head.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+            bool expected = false;
+            if (!r->active.load(std::memory_order_relaxed) &&
+                r->active.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+                return r;
+            }
+        }
+        HazardRecord* r = new HazardRecord;
+        r->active.store(true, std::memory_order_relaxed);
+        r->next = hazardRecords.head.load(std::memory_order_relaxed);
+        while (!hazardRecords.head.compare_exchange_weak(r->next, r, std::memory_order_release,
+                                                         std::memory_order_relaxed)) {
+        }
+        hazardRecords.size.fetch_add(1, std::memory_order_relaxed);
+        return r;
+    }
+
+    // Nodes that are still protected stay in the record for its next owner
+    ~HazardThread() {
+        if (record != nullptr) {
+            record->hazard.store(nullptr);
+            scanHazards(*record);
+            record->active.store(false, std::memory_order_release);
+        }
+    }
+};
+
+inline thread_local HazardThread hazardThread;
+
+// Hands a popped node over for deletion once no hazard pointer holds it
+inline void retireNode(void* pointer, void (*reclaim)(void*)) {
+    HazardRecord& record = hazardThread.get();
+    record.retired.push_back({pointer, reclaim});
+    std::size_t threshold = hazardScanThreshold + 2 * hazardRecords.size.load(std::memory_order_relaxed);
+    if (record.retired.size() >= threshold) {
+        scanHazards(record);
+    }
+}
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/////////////////////////////////////////////////////////////////
+// LockFreeStack
+const int eliminationSlots = 8;
+const int eliminationSpins = 64; // how long an offered node waits for a pop
+
+template <typename T>
+class LockFreeStack {
+private:
+    struct Node {
+        T value;
+        Node* next;
+
+        template <typename... Args>
+        explicit Node(Args&&... args) : value(std::forward<Args>(args)...), next(nullptr) {}
+    };
+
+    // One cache line per slot, so threads exchanging in different slots do not interfere
+    struct alignas(64) EliminationSlot {
+        std::atomic<Node*> offer{nullptr};
+    };
+
+    alignas(64) std::atomic<Node*> top{nullptr};
+    bool elimination;
+    EliminationSlot slots[eliminationSlots];
+
+    static void reclaim(void* node) { delete static_cast<Node*>(node); }
+
+    // A slot's offer after a pop took it; only the pusher resets it to nullptr,
+    // so a pusher never mistakes someone else's node at the same address for its own
+    static Node* takenMarker() {
+        static char tag;
+        return reinterpret_cast<Node*>(&tag);
+    }
+
+    EliminationSlot& randomSlot() {
+        static thread_local std::uint32_t state = 0;
+        if (state == 0) {
+            state = static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(&state)) | 1;
+        }
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return slots[state % eliminationSlots];
+    }
+
+    void pushNode(Node* node);
+    Node* popNode();
+    bool eliminatePush(Node* node);
+    Node* eliminatePop();
+
+public:
+    explicit LockFreeStack(bool useElimination = true) : elimination(useElimination) {}
+    LockFreeStack(const LockFreeStack&) = delete;
+    LockFreeStack& operator=(const LockFreeStack&) = delete;
+    ~LockFreeStack();
+
+    void push(const T& value) { pushNode(new Node(value)); }
+    void push(T&& value) { pushNode(new Node(std::move(value))); }
+    template <typename... Args>
+    void emplace(Args&&... args) { pushNode(new Node(std::forward<Args>(args)...)); }
+    bool tryPop(T& out);
+    T pop();
+    bool isEmpty() const { return top.load(std::memory_order_acquire) == nullptr; } // a snapshot
+};
+
+// Not thread-safe: no other thread may use the stack any more
+template <typename T>
+LockFreeStack<T>::~LockFreeStack() {
+    Node* node = top.load(std::memory_order_relaxed);
+    while (node != nullptr) {
+        Node* next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+template <typename T>
+void LockFreeStack<T>::pushNode(Node* node) {
+    node->next = top.load(std::memory_order_relaxed);
+    while (!top.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        if (elimination && eliminatePush(node)) {
+            return;
+        }
+    }
+}
+
+// Offers node in a random slot for a while; true when a pop took it
+template <typename T>
+bool LockFreeStack<T>::eliminatePush(Node* node) {
+    EliminationSlot& slot = randomSlot();
+    Node* expected = nullptr;
+    if (!slot.offer.compare_exchange_strong(expected, node, std::memory_order_release, std::memory_order_relaxed)) {
+        return false; // the slot is busy
+    }
+    for (int i = 0; i < eliminationSpins; i++) {
+        if (slot.offer.load(std::memory_order_acquire) != node) {
+            break;
+        }
+        cpuRelax();
+    }
+    // Withdraw the offer, unless a pop took it in the meantime
+    expected = node;
+    if (slot.offer.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed)) {
+        return false;
+    }
+    slot.offer.store(nullptr, std::memory_order_release); // expected is takenMarker()
+    return true;
+}
+
+// Takes a node offered by a concurrent push, or returns nullptr
+template <typename T>
+typename LockFreeStack<T>::Node* LockFreeStack<T>::eliminatePop() {
+    EliminationSlot& slot = randomSlot();
+    for (int i = 0; i < eliminationSpins; i++) {
+        Node* offered = slot.offer.load(std::memory_order_acquire);
+        if (offered != nullptr && offered != takenMarker() &&
+            slot.offer.compare_exchange_strong(offered, takenMarker(), std::memory_order_acquire,
+                                               std::memory_order_relaxed)) {
+            return offered;
+        }
+        cpuRelax();
+    }
+    return nullptr;
+}
+
+// Unlinks the top node (or one offered by a concurrent push); nullptr when empty.
+// The caller takes the value and retires the node.
+template <typename T>
+typename LockFreeStack<T>::Node* LockFreeStack<T>::popNode() {
+    HazardRecord& record = hazardThread.get();
+    for (;;) {
+        Node* node = top.load(std::memory_order_acquire);
+        if (node == nullptr) {
+            return nullptr;
+        }
+        // Publish the hazard, then check that node is still the top: if it is,
+        // it was not popped (hence not deleted) before the hazard became visible
+        record.hazard.store(node, std::memory_order_seq_cst);
+        if (top.load(std::memory_order_seq_cst) != node) {
+            continue;
+        }
+        // seq_cst, like the hazard store and load above: the unlink must be ordered
+        // before the hazard scan of whichever thread frees the node (see scanHazards)
+        bool popped = top.compare_exchange_strong(node, node->next, std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed);
+        record.hazard.store(nullptr, std::memory_order_release);
+        if (popped) {
+            return node;
+        }
+        if (elimination) {
+            if (Node* offered = eliminatePop()) {
+                return offered;
+            }
+        }
+    }
+}
+
+// Pop into out: false when the stack is empty
+template <typename T>
+bool LockFreeStack<T>::tryPop(T& out) {
+    Node* node = popNode();
+    if (node == nullptr) {
+        return false;
+    }
+    out = std::move(node->value);
+    retireNode(node, &LockFreeStack::reclaim);
+    return true;
+}
+
+// Pop an element from the stack
+template <typename T>
+T LockFreeStack<T>::pop() {
+    Node* node = popNode();
+    if (node == nullptr) {
+        throw std::underflow_error("Stack underflow");
+    }
+    T value(std::move(node->value));
+    retireNode(node, &LockFreeStack::reclaim);
+    return value;
+}
+
+/*
+Time Complexity:
+- push / tryPop: O(1) expected; a failed CAS is retried, so a single
+  operation is not bounded (lock-free: some thread always makes progress)
+- every popping thread runs an O(H log H) scan per ~H + 64 pops
+  (H = number of threads that ever used a hazard pointer), amortized O(log H)
+Space Complexity: O(n) nodes plus at most H * (2H + 64) popped nodes
+waiting to be deleted
+Notes:
+A node is one allocation per push; with a thread-caching malloc that is
+cheap, and it is what makes hazard pointers simple (a node is never reused
+while some thread may still read it).
+The order of concurrent operations is the order of their successful CASes;
+an eliminated push/pop pair counts as a push immediately followed by its
+pop.
+*/
+
+#endif
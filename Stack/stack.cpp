@@ -10,81 +10,13 @@ It resembles a stack of plates in a cafeteria.
 A stack may have limited capacity or may be expandable.
 
 Stacks are useful if data has to be stored and then retrieved in a reverse order.
-*/
-
-#include <iostream>
-#include <stdexcept>
-#include "stack.h" // Assuming you have a stack.h file
-using namespace std;
-
-// Constructor to initialize the stack
-Stack::Stack(int size) {
-    arr = new int[size];
-    capacity = size;
-    top = -1;
-}
-
-// Destructor to free memory
-Stack::~Stack() {
-    delete[] arr;
-}
-
-// Return the top value of the stack
-int Stack::topValue() const {
-    if (isEmpty()) {
-        throw underflow_error("Stack is empty");
-    }
-    return arr[top];
-}
 
-// Print all elements in the stack
-void Stack::printStack() const {
-    if (isEmpty()) {
-        cout << "Stack is empty." << endl;
-        return;
-    }
-    cout << "Stack elements: ";
-    for (int i = 0; i <= top; i++) {
-        cout << arr[i] << " ";
-    }
-    cout << endl;
-}
-
-// Push an element onto the stack
-void Stack::push(int value) {
-    if (isFull()) {
-        throw overflow_error("Stack overflow");
-    }
-    arr[++top] = value;
-}
-
-// Pop an element from the stack
-int Stack::pop() {
-    if (isEmpty()) {
-        throw underflow_error("Stack underflow");
-    }
-    return arr[top--];
-}
-
-// Peek the top element of the stack
-int Stack::peek() const {
-    if (isEmpty()) {
-        throw underflow_error("Stack is empty");
-    }
-    return arr[top];
-}
-
-// Check if the stack is empty
-bool Stack::isEmpty() const {
-    return top == -1;
-}
+Stack (stack.h) is the expandable kind: a template over the element type
+whose array doubles when it is full. Its members are defined in stack.h;
+Stack<int> is compiled here once (stack.h declares it extern), so programs
+that use it link stack.cpp instead of instantiating it themselves.
+*/
 
-// Check if the stack is full
-bool Stack::isFull() const {
-    return top == capacity - 1;
-}
+#include "stack.h"
 
-// Get the current size of the stack
-int Stack::size() const {
-    return top + 1;
-}
+template class Stack<int>;
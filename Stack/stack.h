@@ -2,23 +2,477 @@
 #ifndef STACK_H
 #define STACK_H
 
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+Stack<T, Allocator>: array-based stack that grows when it is full.
+- push / emplace construct the element in place; when the array is full
+  it is reallocated to twice its capacity, so n pushes cost O(n) in total
+  (amortized O(1) each) and the array is copied only log n times
+- elements are moved, not copied, into the larger array (when their move
+  constructor cannot throw; otherwise they are copied so a failed
+  reallocation leaves the stack unchanged)
+- the constructor argument and reserve() are only capacity hints
+- pop / peek / topValue throw underflow_error on an empty stack, as before;
+  tryPush / tryPop report failure by returning false instead of throwing
+
+T defaults to int, so the int stack keeps its old spelling:
+    Stack stack(expr.length()); // Stack<int>, reserves expr.length() ints
+    Stack<char> brackets;
+    Stack<std::string> words;
+    words.emplace(3, 'x'); // constructs "xxx" on the stack
+
+SmallStack<T, N> (Stack<T, Allocator, N>) keeps its first N elements in an
+array inside the object and allocates only when it grows beyond N:
+    SmallStack<char, 64> brackets; // no allocation until the 65th push
+The inline elements make the object N * sizeof(T) bytes larger, so it is
+meant for short-lived local stacks of a usually small, bounded depth
+(brackets, operators), not for large N or stacks stored in containers.
+Moving a SmallStack whose elements are inline moves them one by one.
+*/
+
+// Inline storage of SmallStack: room for N elements, constructed only when pushed
+template <typename T, std::size_t N>
+struct StackInlineBuffer {
+    alignas(T) unsigned char bytes[N * sizeof(T)];
+    T* data() noexcept { return reinterpret_cast<T*>(bytes); }
+    const T* data() const noexcept { return reinterpret_cast<const T*>(bytes); }
+};
+
+template <typename T>
+struct StackInlineBuffer<T, 0> {
+    T* data() noexcept { return nullptr; }
+    const T* data() const noexcept { return nullptr; }
+};
+
+template <typename T = int, typename Allocator = std::allocator<T>, std::size_t N = 0>
 class Stack {
 private:
-    int* arr;
-    int top;
-    int capacity;
+    using AllocTraits = std::allocator_traits<Allocator>;
+    static constexpr bool nothrowMove = N == 0 || std::is_nothrow_move_constructible<T>::value;
+    // Move assignment and swap can take the other array only if the allocators move with it or are equal
+    static constexpr bool propagateOnMove = AllocTraits::propagate_on_container_move_assignment::value;
+    static constexpr bool propagateOnSwap = AllocTraits::propagate_on_container_swap::value;
+    static constexpr bool nothrowMoveAssign =
+        nothrowMove && (propagateOnMove || AllocTraits::is_always_equal::value);
+
+    Allocator alloc;
+    StackInlineBuffer<T, N> inlineBuffer; // before arr, which starts out pointing into it
+    T* arr = inlineBuffer.data();
+    std::size_t count = 0;
+    std::size_t cap = N;
+
+    bool isInline() const { return N > 0 && arr == inlineBuffer.data(); }
+    bool sameAllocator(const Stack& other) const {
+        return AllocTraits::is_always_equal::value || alloc == other.alloc;
+    }
+    std::size_t grownCapacity(std::size_t minCapacity) const;
+    void relocate(std::size_t newCapacity);
+    template <typename... Args>
+    T& emplaceGrow(Args&&... args);
+    void destroyAll() noexcept;
+    void releaseStorage() noexcept;
+    void takeFrom(Stack& other) noexcept(nothrowMove);
 
 public:
-    Stack(int size);
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+
+    Stack() = default;
+    explicit Stack(std::size_t initialCapacity, const Allocator& allocator = Allocator());
+    Stack(const Stack& other);
+    Stack(Stack&& other) noexcept(nothrowMove);
+    Stack& operator=(const Stack& other);
+    Stack& operator=(Stack&& other) noexcept(nothrowMoveAssign);
     ~Stack();
-    int topValue() const;
+
+    const T& topValue() const;
     void printStack() const;
-    void push(int value);
-    int pop();
-    int peek() const;
-    bool isEmpty() const;
-    bool isFull() const;
-    int size() const;
+    void push(const T& value);
+    void push(T&& value);
+    template <typename... Args>
+    T& emplace(Args&&... args);
+    T pop();
+    T& peek();
+    const T& peek() const;
+    bool isEmpty() const { return count == 0; }
+    bool isFull() const { return count == cap; } // the next push reallocates
+    std::size_t size() const { return count; }
+    std::size_t capacity() const { return cap; }
+
+    bool tryPush(const T& value);
+    bool tryPush(T&& value);
+    bool tryPop(T& out) noexcept(std::is_nothrow_move_assignable<T>::value);
+    void reserve(std::size_t newCapacity);
+    void clear() noexcept;
+    void swap(Stack& other) noexcept(nothrowMoveAssign);
 };
 
+template <typename T, std::size_t N, typename Allocator = std::allocator<T>>
+using SmallStack = Stack<T, Allocator, N>;
+
+// Capacity after growth: double the current one (at least 8), never less than minCapacity
+template <typename T, typename Allocator, std::size_t N>
+std::size_t Stack<T, Allocator, N>::grownCapacity(std::size_t minCapacity) const {
+    const std::size_t maxCapacity = AllocTraits::max_size(alloc);
+    if (minCapacity > maxCapacity) {
+        throw std::length_error("Stack capacity too large");
+    }
+    std::size_t doubled = cap < maxCapacity / 2 ? 2 * cap : maxCapacity;
+    return std::max<std::size_t>({minCapacity, doubled, 8});
+}
+
+// Moves the elements into a new array of newCapacity >= count elements
+template <typename T, typename Allocator, std::size_t N>
+void Stack<T, Allocator, N>::relocate(std::size_t newCapacity) {
+    T* newArr = AllocTraits::allocate(alloc, newCapacity);
+    std::size_t built = 0;
+    try {
+        for (; built < count; built++) {
+            AllocTraits::construct(alloc, newArr + built, std::move_if_noexcept(arr[built]));
+        }
+    } catch (...) {
+        for (std::size_t i = 0; i < built; i++) {
+            AllocTraits::destroy(alloc, newArr + i);
+        }
+        AllocTraits::deallocate(alloc, newArr, newCapacity);
+        throw;
+    }
+    destroyAll();
+    releaseStorage();
+    arr = newArr;
+    cap = newCapacity;
+}
+
+/*
+Slow path of emplace, when the array is full. The new element is built in
+the new array before the old elements are moved, so push(s.peek()) works:
+args may refer to an element of the old array.
+*/
+template <typename T, typename Allocator, std::size_t N>
+template <typename... Args>
+T& Stack<T, Allocator, N>::emplaceGrow(Args&&... args) {
+    const std::size_t newCapacity = grownCapacity(count + 1);
+    T* newArr = AllocTraits::allocate(alloc, newCapacity);
+    std::size_t built = 0;
+    try {
+        AllocTraits::construct(alloc, newArr + count, std::forward<Args>(args)...);
+        try {
+            for (; built < count; built++) {
+                AllocTraits::construct(alloc, newArr + built, std::move_if_noexcept(arr[built]));
+            }
+        } catch (...) {
+            AllocTraits::destroy(alloc, newArr + count);
+            throw;
+        }
+    } catch (...) {
+        for (std::size_t i = 0; i < built; i++) {
+            AllocTraits::destroy(alloc, newArr + i);
+        }
+        AllocTraits::deallocate(alloc, newArr, newCapacity);
+        throw;
+    }
+    destroyAll();
+    releaseStorage();
+    arr = newArr;
+    cap = newCapacity;
+    return arr[count++];
+}
+
+template <typename T, typename Allocator, std::size_t N>
+void Stack<T, Allocator, N>::destroyAll() noexcept {
+    if (!std::is_trivially_destructible<T>::value) {
+        for (std::size_t i = 0; i < count; i++) {
+            AllocTraits::destroy(alloc, arr + i);
+        }
+    }
+}
+
+// Frees the heap array, if any (the elements must already be destroyed)
+template <typename T, typename Allocator, std::size_t N>
+void Stack<T, Allocator, N>::releaseStorage() noexcept {
+    if (arr != nullptr && !isInline()) {
+        AllocTraits::deallocate(alloc, arr, cap);
+    }
+}
+
+// Takes the elements of other into this empty, inline stack; other is left empty
+template <typename T, typename Allocator, std::size_t N>
+void Stack<T, Allocator, N>::takeFrom(Stack& other) noexcept(nothrowMove) {
+    if (other.isInline()) {
+        for (; count < other.count; count++) {
+            AllocTraits::construct(alloc, arr + count, std::move(other.arr[count]));
+        }
+        other.clear();
+    } else {
+        arr = other.arr;
+        count = other.count;
+        cap = other.cap;
+        other.arr = other.inlineBuffer.data();
+        other.count = 0;
+        other.cap = N;
+    }
+}
+
+// Constructor: initialCapacity elements are reserved, more can be pushed
+template <typename T, typename Allocator, std::size_t N>
+Stack<T, Allocator, N>::Stack(std::size_t initialCapacity, const Allocator& allocator) : alloc(allocator) {
+    reserve(initialCapacity);
+}
+
+template <typename T, typename Allocator, std::size_t N>
+Stack<T, Allocator, N>::Stack(const Stack& other)
+    : alloc(AllocTraits::select_on_container_copy_construction(other.alloc)) {
+    reserve(other.count);
+    try {
+        for (; count < other.count; count++) {
+            AllocTraits::construct(alloc, arr + count, other.arr[count]);
+        }
+    } catch (...) {
+        // No destructor runs for a throwing constructor; alloc is destroyed by the unwinding
+        clear();
+        releaseStorage();
+        throw;
+    }
+}
+
+template <typename T, typename Allocator, std::size_t N>
+Stack<T, Allocator, N>::Stack(Stack&& other) noexcept(nothrowMove) : alloc(std::move(other.alloc)) {
+    takeFrom(other);
+}
+
+template <typename T, typename Allocator, std::size_t N>
+Stack<T, Allocator, N>& Stack<T, Allocator, N>::operator=(const Stack& other) {
+    if (this != &other) {
+        Stack copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+/*
+Follows the allocator rules of the standard containers: the allocator is
+moved only when propagate_on_container_move_assignment says so; otherwise
+other's array is taken only if both allocators are equal (either can free
+it), and with unequal allocators (two std::pmr memory resources) the
+elements are moved one by one into storage of this stack's allocator.
+*/
+template <typename T, typename Allocator, std::size_t N>
+Stack<T, Allocator, N>& Stack<T, Allocator, N>::operator=(Stack&& other) noexcept(nothrowMoveAssign) {
+    if (this == &other) {
+        return *this;
+    }
+    if (!propagateOnMove && !sameAllocator(other)) {
+        clear();
+        reserve(other.count);
+        for (; count < other.count; count++) {
+            AllocTraits::construct(alloc, arr + count, std::move(other.arr[count]));
+        }
+        other.clear();
+        return *this;
+    }
+    clear();
+    releaseStorage();
+    arr = inlineBuffer.data();
+    cap = N;
+    if constexpr (propagateOnMove) {
+        alloc = std::move(other.alloc);
+    }
+    takeFrom(other);
+    return *this;
+}
+
+// Destructor to free memory
+template <typename T, typename Allocator, std::size_t N>
+Stack<T, Allocator, N>::~Stack() {
+    destroyAll();
+    releaseStorage();
+}
+
+// Return the top value of the stack
+template <typename T, typename Allocator, std::size_t N>
+const T& Stack<T, Allocator, N>::topValue() const {
+    if (isEmpty()) {
+        throw std::underflow_error("Stack is empty");
+    }
+    return arr[count - 1];
+}
+
+// Print all elements in the stack
+template <typename T, typename Allocator, std::size_t N>
+void Stack<T, Allocator, N>::printStack() const {
+    if (isEmpty()) {
+        std::cout << "Stack is empty." << std::endl;
+        return;
+    }
+    std::cout << "Stack elements: ";
+    for (std::size_t i = 0; i < count; i++) {
+        std::cout << arr[i] << " ";
+    }
+    std::cout << std::endl;
+}
+
+// Push an element onto the stack
+template <typename T, typename Allocator, std::size_t N>
+void Stack<T, Allocator, N>::push(const T& value) {
+    emplace(value);
+}
+
+template <typename T, typename Allocator, std::size_t N>
+void Stack<T, Allocator, N>::push(T&& value) {
+    emplace(std::move(value));
+}
+
+// Construct an element on top of the stack from args
+template <typename T, typename Allocator, std::size_t N>
+template <typename... Args>
+T& Stack<T, Allocator, N>::emplace(Args&&... args) {
+    if (count == cap) {
+        return emplaceGrow(std::forward<Args>(args)...);
+    }
+    AllocTraits::construct(alloc, arr + count, std::forward<Args>(args)...);
+    return arr[count++];
+}
+
+// Pop an element from the stack
+template <typename T, typename Allocator, std::size_t N>
+T Stack<T, Allocator, N>::pop() {
+    if (isEmpty()) {
+        throw std::underflow_error("Stack underflow");
+    }
+    T value = std::move(arr[count - 1]);
+    AllocTraits::destroy(alloc, arr + --count);
+    return value;
+}
+
+// Peek the top element of the stack
+template <typename T, typename Allocator, std::size_t N>
+T& Stack<T, Allocator, N>::peek() {
+    if (isEmpty()) {
+        throw std::underflow_error("Stack is empty");
+    }
+    return arr[count - 1];
+}
+
+template <typename T, typename Allocator, std::size_t N>
+const T& Stack<T, Allocator, N>::peek() const {
+    if (isEmpty()) {
+        throw std::underflow_error("Stack is empty");
+    }
+    return arr[count - 1];
+}
+
+// Push without throwing when memory runs out: false, and the stack is unchanged
+template <typename T, typename Allocator, std::size_t N>
+bool Stack<T, Allocator, N>::tryPush(const T& value) {
+    if (count < cap) {
+        AllocTraits::construct(alloc, arr + count++, value);
+        return true;
+    }
+    try {
+        emplaceGrow(value);
+    } catch (const std::bad_alloc&) {
+        return false;
+    } catch (const std::length_error&) {
+        return false;
+    }
+    return true;
+}
+
+template <typename T, typename Allocator, std::size_t N>
+bool Stack<T, Allocator, N>::tryPush(T&& value) {
+    if (count < cap) {
+        AllocTraits::construct(alloc, arr + count++, std::move(value));
+        return true;
+    }
+    try {
+        emplaceGrow(std::move(value));
+    } catch (const std::bad_alloc&) {
+        return false;
+    } catch (const std::length_error&) {
+        return false;
+    }
+    return true;
+}
+
+// Pop into out without throwing: false when the stack is empty
+template <typename T, typename Allocator, std::size_t N>
+bool Stack<T, Allocator, N>::tryPop(T& out) noexcept(std::is_nothrow_move_assignable<T>::value) {
+    if (count == 0) {
+        return false;
+    }
+    out = std::move(arr[count - 1]);
+    AllocTraits::destroy(alloc, arr + --count);
+    return true;
+}
+
+// Make room for newCapacity elements, so that many pushes do not reallocate
+template <typename T, typename Allocator, std::size_t N>
+void Stack<T, Allocator, N>::reserve(std::size_t newCapacity) {
+    if (newCapacity > cap) {
+        if (newCapacity > AllocTraits::max_size(alloc)) {
+            throw std::length_error("Stack capacity too large");
+        }
+        relocate(newCapacity);
+    }
+}
+
+// Remove all elements, keeping the capacity
+template <typename T, typename Allocator, std::size_t N>
+void Stack<T, Allocator, N>::clear() noexcept {
+    destroyAll();
+    count = 0;
+}
+
+// Heap arrays are exchanged when the allocators are swapped too (propagate_on_container_swap)
+// or are equal; inline elements and arrays of unequal allocators go through move assignment
+template <typename T, typename Allocator, std::size_t N>
+void Stack<T, Allocator, N>::swap(Stack& other) noexcept(nothrowMoveAssign) {
+    if (this == &other) {
+        return;
+    }
+    if (!isInline() && !other.isInline() && (propagateOnSwap || sameAllocator(other))) {
+        std::swap(arr, other.arr);
+        std::swap(count, other.count);
+        std::swap(cap, other.cap);
+        if constexpr (propagateOnSwap) {
+            using std::swap;
+            swap(alloc, other.alloc);
+        }
+        return;
+    }
+    Stack temp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(temp);
+}
+
+// Stack<int> is compiled once, in stack.cpp
+extern template class Stack<int>;
+
+/*
+Time Complexity:
+- push / emplace / tryPush: amortized O(1), O(n) for the push that reallocates
+- pop / tryPop / peek / topValue / isEmpty / size: O(1)
+- reserve: O(n) when it reallocates
+Space Complexity: O(capacity), at most 2n after growth (plus the N inline
+elements of a SmallStack)
+Notes:
+Growth by a factor of 2 means that every element is moved at most about
+twice over all reallocations (n/2 + n/4 + ... < n moves in total), which
+is what makes push amortized O(1). A fixed capacity (the old Stack) needed
+the caller to know the maximum depth, which usually meant sizing the
+stack for the whole input.
+A SmallStack whose depth stays within N never calls the allocator, which
+matters when the stack lives for one short call (one expression) and the
+allocation would cost more than the work done on the stack.
+*/
+
 #endif
@@ -0,0 +1,211 @@
+/*
+Concurrent stack benchmark
+==========================
+Measures the throughput of a stack shared by several threads:
+- mutex: Stack<long long> guarded by a std::mutex
+- lock_free: LockFreeStack without elimination (plain Treiber stack)
+- lock_free_elimination: LockFreeStack with the elimination array
+
+Every thread runs `ops` operations on the same stack, which starts with
+`prefill` elements. Workloads:
+- pairs: push, then pop (a shared free list: take a block, give one back)
+- random: push or pop with probability 1/2 each (a work pool)
+The popped values are summed and checked against the pushed ones, so a
+lost or duplicated element is reported.
+
+Build and run:
+  g++ -O2 -std=c++17 -pthread stack_benchmark.cpp stack.cpp -o stack_benchmark
+  ./stack_benchmark --max-threads 16 --ops 1000000
+
+Options:
+  --max-threads T   thread counts 1, 2, 4, ... up to T (default: 2 * hardware threads, at least 8)
+  --ops N           operations per thread (default 1000000)
+  --prefill N       elements in the stack at the start (default 1000)
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include "stack.h"
+#include "lock_free_stack.h"
+using namespace std;
+
+/////////////////////////////////////////////////////////////////
+// Stacks under test
+class MutexStack {
+    mutex lock;
+    Stack<long long> stack;
+
+public:
+    void push(long long value) {
+        lock_guard<mutex> guard(lock);
+        stack.push(value);
+    }
+    bool tryPop(long long& out) {
+        lock_guard<mutex> guard(lock);
+        return stack.tryPop(out);
+    }
+};
+
+class LockFree : public LockFreeStack<long long> {
+public:
+    LockFree() : LockFreeStack<long long>(false) {}
+};
+
+class LockFreeElimination : public LockFreeStack<long long> {
+public:
+    LockFreeElimination() : LockFreeStack<long long>(true) {}
+};
+
+/////////////////////////////////////////////////////////////////
+// Workloads
+enum class Workload { Pairs, Random };
+
+const char* workloadName(Workload w) {
+    return w == Workload::Pairs ? "pairs" : "random";
+}
+
+struct Options {
+    int maxThreads = 0;
+    long long ops = 1000000;
+    long long prefill = 1000;
+};
+
+struct Result {
+    double seconds;
+    bool valid;
+};
+
+// Values pushed by a thread are unique: (thread + 1) * 2^40 + counter.
+// The checksums are unsigned and may wrap, which is fine for an equality check
+template <class SharedStack>
+Result runWorkload(Workload workload, int threads, const Options& options) {
+    SharedStack stack;
+    unsigned long long pushedSum = 0;
+    for (long long i = 0; i < options.prefill; i++) {
+        stack.push(i);
+        pushedSum += i;
+    }
+
+    vector<unsigned long long> pushed(threads, 0), popped(threads, 0);
+    atomic<int> ready{0};
+    atomic<bool> go{false};
+    auto worker = [&](int t) {
+        unsigned state = 2463534242u + t;
+        long long next = (static_cast<long long>(t) + 1) << 40;
+        unsigned long long pushedHere = 0, poppedHere = 0;
+        long long value;
+        ready.fetch_add(1);
+        while (!go.load(memory_order_acquire)) {
+        }
+        for (long long i = 0; i < options.ops; i++) {
+            bool push;
+            if (workload == Workload::Pairs) {
+                push = (i & 1) == 0;
+            } else {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+                push = (state & 1) != 0;
+            }
+            if (push) {
+                stack.push(next);
+                pushedHere += next++;
+            } else if (stack.tryPop(value)) {
+                poppedHere += value;
+            }
+        }
+        pushed[t] = pushedHere;
+        popped[t] = poppedHere;
+    };
+
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back(worker, t);
+    }
+    while (ready.load() < threads) {
+        this_thread::yield();
+    }
+    auto start = chrono::steady_clock::now();
+    go.store(true, memory_order_release);
+    for (thread& w : workers) {
+        w.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // Whatever was pushed and not popped must still be in the stack
+    unsigned long long poppedSum = 0;
+    long long value;
+    for (int t = 0; t < threads; t++) {
+        pushedSum += pushed[t];
+        poppedSum += popped[t];
+    }
+    while (stack.tryPop(value)) {
+        poppedSum += value;
+    }
+    return {seconds, pushedSum == poppedSum};
+}
+
+/////////////////////////////////////////////////////////////////
+// main
+Options parseOptions(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            throw invalid_argument("missing value for " + arg);
+        }
+        string value = argv[++i];
+        if (arg == "--max-threads") {
+            options.maxThreads = stoi(value);
+        } else if (arg == "--ops") {
+            options.ops = stoll(value);
+        } else if (arg == "--prefill") {
+            options.prefill = stoll(value);
+        } else {
+            throw invalid_argument("unknown option " + arg);
+        }
+    }
+    if (options.maxThreads <= 0) {
+        options.maxThreads = max(8, 2 * static_cast<int>(thread::hardware_concurrency()));
+    }
+    return options;
+}
+
+template <class SharedStack>
+bool report(const char* name, Workload workload, int threads, const Options& options) {
+    Result r = runWorkload<SharedStack>(workload, threads, options);
+    double mops = threads * options.ops / r.seconds / 1e6;
+    cout << left << setw(24) << name << setw(8) << workloadName(workload) << right << setw(8) << threads
+         << fixed << setprecision(2) << setw(12) << mops << (r.valid ? "" : "   ELEMENTS LOST OR DUPLICATED") << endl;
+    return r.valid;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    cout << "hardware threads: " << thread::hardware_concurrency() << endl;
+    cout << left << setw(24) << "stack" << setw(8) << "load" << right << setw(8) << "threads" << setw(12) << "Mops/s"
+         << endl;
+    bool valid = true;
+    for (Workload workload : {Workload::Pairs, Workload::Random}) {
+        for (int threads = 1; threads <= options.maxThreads; threads *= 2) {
+            valid &= report<MutexStack>("mutex", workload, threads, options);
+            valid &= report<LockFree>("lock_free", workload, threads, options);
+            valid &= report<LockFreeElimination>("lock_free_elimination", workload, threads, options);
+        }
+    }
+    return valid ? 0 : 1;
+}
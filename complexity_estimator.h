@@ -0,0 +1,303 @@
+// complexity_estimator.h
+#ifndef COMPLEXITY_ESTIMATOR_H
+#define COMPLEXITY_ESTIMATOR_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+/*
+Empirical complexity estimator
+==============================
+Complexity.cpp states the complexity of every example in a comment; this
+measures it. A function is run at geometrically growing input sizes n,
+every size is timed several times with a monotonic clock
+(std::chrono::steady_clock), and the fastest time of every size (the one
+least disturbed by other processes and interrupts) is fitted against
+    1, log n, n, n log n, n^2, 2^n
+For each class f, T(n) ~ a + c * f(n) is fitted by least squares on the
+relative residuals (T - a - c f) / T, and the class with the smallest
+error (their root mean square) wins; a simpler class wins when its error
+is within 10% of that. The intercept a absorbs the fixed
+cost of a call (allocating a buffer, starting a loop), which would
+otherwise bend the small sizes towards a steeper class; relative residuals
+give every size the same weight, so the fit follows the shape of T(n) over
+the whole range instead of only its largest value.
+
+    ComplexityEstimate e = estimateComplexity(
+        [](long long n) { vector<int> v(n); iota(v.rbegin(), v.rend(), 0); return v; }, // untimed
+        [](vector<int>& v) { Sort(v.data(), v.size()); });                                // timed
+    cout << describe(e) << endl; // O(n^2): T(n) ~ 850 ns + 1.2 ns * n^2 (fit error 3.1%, next best ...)
+
+    estimateRunComplexity([](long long n) {                                              // all timed
+        int result = exponentialTimeExample(n);
+        doNotOptimize(result);
+    }, options);
+
+A regression test can then check e.best against the expected class, e.g.
+catch an O(n) insert in a container that should be O(1) or O(log n).
+
+Reading the result: the fit can only tell apart classes whose shapes differ
+over the measured range. n and n log n need n to span a few orders of
+magnitude; 2^n needs small n growing by 1 (options.growth close to 1).
+Operations much shorter than a microsecond (one lookup in a set) are close
+to the clock resolution: let run do a fixed batch of them (1000 lookups),
+which multiplies T(n) by a constant and keeps the class.
+*/
+
+enum class ComplexityClass { Constant, Logarithmic, Linear, Linearithmic, Quadratic, Exponential };
+
+inline const char* complexityClassName(ComplexityClass c) {
+    switch (c) {
+    case ComplexityClass::Constant: return "O(1)";
+    case ComplexityClass::Logarithmic: return "O(log n)";
+    case ComplexityClass::Linear: return "O(n)";
+    case ComplexityClass::Linearithmic: return "O(n log n)";
+    case ComplexityClass::Quadratic: return "O(n^2)";
+    case ComplexityClass::Exponential: return "O(2^n)";
+    }
+    return "?";
+}
+
+// f(n) of a class; infinity when it does not fit in a double
+inline double complexityFunction(ComplexityClass c, double n) {
+    switch (c) {
+    case ComplexityClass::Constant: return 1;
+    case ComplexityClass::Logarithmic: return std::log2(std::max(n, 2.0));
+    case ComplexityClass::Linear: return n;
+    case ComplexityClass::Linearithmic: return n * std::log2(std::max(n, 2.0));
+    case ComplexityClass::Quadratic: return n * n;
+    case ComplexityClass::Exponential: return std::exp2(n);
+    }
+    return 0;
+}
+
+const ComplexityClass allComplexityClasses[] = {
+    ComplexityClass::Constant, ComplexityClass::Logarithmic, ComplexityClass::Linear,
+    ComplexityClass::Linearithmic, ComplexityClass::Quadratic, ComplexityClass::Exponential
+};
+
+struct ComplexityOptions {
+    long long minN = 16;
+    long long maxN = 1 << 20;
+    double growth = 2; // next n = max(n + 1, n * growth)
+    int repetitions = 5; // timed runs per n (the fastest is used)
+    double maxSecondsPerRun = 0.5; // stop growing n once one run takes this long
+};
+
+struct ComplexitySample {
+    long long n;
+    double seconds; // fastest of the repetitions
+};
+
+struct ComplexityFit {
+    ComplexityClass complexity;
+    double intercept; // seconds, fixed cost of a run (0 for the constant class)
+    double constant; // seconds per unit of f(n)
+    double error; // root mean square of the relative residuals
+};
+
+struct ComplexityEstimate {
+    ComplexityClass best;
+    double intercept;
+    double constant;
+    double error;
+    std::vector<ComplexitySample> samples;
+    std::vector<ComplexityFit> fits; // every class, best first
+};
+
+/*
+Weighted least squares fit of T ~ a + c * f with weights 1 / T^2, i.e. of
+the relative residuals (T - a - c f) / T. The constant class has f = 1 and
+only one parameter. A negative intercept is not a cost, so the fit is then
+redone through the origin; a class whose c is not positive does not grow
+with n and is left out.
+*/
+inline bool fitComplexityClass(const std::vector<ComplexitySample>& samples, ComplexityClass c, ComplexityFit& fit) {
+    std::vector<double> f(samples.size());
+    double largest = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        f[i] = complexityFunction(c, static_cast<double>(samples[i].n));
+        if (!std::isfinite(f[i])) {
+            return false;
+        }
+        largest = std::max(largest, f[i]);
+    }
+    // f / largest is in (0, 1], which keeps the sums below well conditioned
+    double sumW = 0, sumWF = 0, sumWFF = 0, sumWT = 0, sumWFT = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        double w = 1 / (samples[i].seconds * samples[i].seconds);
+        double g = f[i] / largest;
+        sumW += w;
+        sumWF += w * g;
+        sumWFF += w * g * g;
+        sumWT += w * samples[i].seconds;
+        sumWFT += w * g * samples[i].seconds;
+    }
+
+    double a = 0, slope = 0;
+    int parameters = 1;
+    if (c == ComplexityClass::Constant) {
+        slope = sumWT / sumW; // f = 1: the constant itself
+    } else {
+        double determinant = sumW * sumWFF - sumWF * sumWF;
+        if (samples.size() > 2 && determinant > 1e-12 * sumW * sumWFF) {
+            a = (sumWT * sumWFF - sumWF * sumWFT) / determinant;
+            slope = (sumW * sumWFT - sumWF * sumWT) / determinant;
+            parameters = 2;
+        }
+        if (parameters == 1 || a < 0) {
+            a = 0;
+            slope = sumWFT / sumWFF;
+            parameters = 1;
+        }
+        if (slope <= 0) {
+            return false;
+        }
+    }
+
+    double squares = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        double model = c == ComplexityClass::Constant ? slope : a + slope * f[i] / largest;
+        double relative = (samples[i].seconds - model) / samples[i].seconds;
+        squares += relative * relative;
+    }
+    // Divided by the degrees of freedom, so the extra parameter is not a free advantage
+    size_t degrees = samples.size() > static_cast<size_t>(parameters) ? samples.size() - parameters : 1;
+    fit = {c, a, c == ComplexityClass::Constant ? slope : slope / largest, std::sqrt(squares / degrees)};
+    return true;
+}
+
+// Fits the samples against every class
+inline ComplexityEstimate fitComplexity(const std::vector<ComplexitySample>& samples) {
+    ComplexityEstimate estimate{ComplexityClass::Constant, 0, 0, std::numeric_limits<double>::infinity(), samples, {}};
+    if (samples.empty()) {
+        return estimate;
+    }
+    for (ComplexityClass c : allComplexityClasses) {
+        ComplexityFit fit;
+        if (fitComplexityClass(samples, c, fit)) {
+            estimate.fits.push_back(fit);
+        }
+    }
+    std::stable_sort(estimate.fits.begin(), estimate.fits.end(),
+                     [](const ComplexityFit& a, const ComplexityFit& b) { return a.error < b.error; });
+    // A steeper class with a tiny c can always follow the noise a little better: the
+    // simplest class within 10% of the smallest error wins
+    auto simplest = estimate.fits.begin();
+    for (auto fit = estimate.fits.begin(); fit != estimate.fits.end(); ++fit) {
+        if (fit->error <= estimate.fits[0].error * 1.1 && fit->complexity < simplest->complexity) {
+            simplest = fit;
+        }
+    }
+    std::rotate(estimate.fits.begin(), simplest, simplest + (simplest != estimate.fits.end()));
+    if (!estimate.fits.empty()) {
+        estimate.best = estimate.fits[0].complexity;
+        estimate.intercept = estimate.fits[0].intercept;
+        estimate.constant = estimate.fits[0].constant;
+        estimate.error = estimate.fits[0].error;
+    }
+    return estimate;
+}
+
+/*
+Makes the compiler assume that value is read and modified here, so work
+that produces it cannot be removed, and work that uses it cannot be
+computed once and reused across runs (e.g. a pure function of n).
+*/
+template <class T>
+inline void doNotOptimize(T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : "+m"(value) : : "memory");
+#else
+    static volatile char sink;
+    sink = *reinterpret_cast<volatile char*>(&value);
+#endif
+}
+
+// Median cost of reading the clock twice, subtracted from every measurement
+inline double clockOverheadSeconds() {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> times;
+    for (int i = 0; i < 101; i++) {
+        Clock::time_point start = Clock::now();
+        times.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+/*
+prepare(n) builds the input of size n (not timed) and run(input) is the
+operation that is timed. prepare is called again before every repetition,
+because run may modify its input (a sort, an insert...).
+*/
+template <class Prepare, class Run>
+ComplexityEstimate estimateComplexity(Prepare prepare, Run run, const ComplexityOptions& options = ComplexityOptions()) {
+    using Clock = std::chrono::steady_clock;
+    const double overhead = clockOverheadSeconds();
+    std::vector<ComplexitySample> samples;
+    for (long long n = options.minN; n <= options.maxN;
+         n = std::max(n + 1, static_cast<long long>(static_cast<double>(n) * options.growth))) {
+        std::vector<double> times;
+        {
+            auto warmUp = prepare(n); // untimed: first-touch page faults, cold caches
+            doNotOptimize(warmUp);
+            run(warmUp);
+        }
+        for (int r = 0; r < std::max(1, options.repetitions); r++) {
+            auto input = prepare(n);
+            doNotOptimize(input);
+            Clock::time_point start = Clock::now();
+            run(input);
+            doNotOptimize(input);
+            double seconds = std::chrono::duration<double>(Clock::now() - start).count() - overhead;
+            times.push_back(std::max(seconds, 1e-9));
+        }
+        samples.push_back({n, *std::min_element(times.begin(), times.end())});
+        if (samples.back().seconds > options.maxSecondsPerRun) {
+            break;
+        }
+    }
+    return fitComplexity(samples);
+}
+
+// run(n) does all the work for size n, including building its input (all of it is timed).
+// A result that is not stored anywhere should be passed to doNotOptimize.
+template <class Run>
+ComplexityEstimate estimateRunComplexity(Run run, const ComplexityOptions& options = ComplexityOptions()) {
+    return estimateComplexity([](long long n) { return n; }, [&run](long long n) { run(n); }, options);
+}
+
+// "O(n log n): T(n) ~ 240 ns + 3.2 ns * n log n (fit error 4.1%, next best O(n) 12.0%)"
+inline std::string describe(const ComplexityEstimate& estimate) {
+    if (estimate.fits.empty()) {
+        return "no measurements";
+    }
+    static const char* const terms[] = {"", " * log n", " * n", " * n log n", " * n^2", " * 2^n"};
+    char text[200];
+    int length = std::snprintf(text, sizeof(text), "%s: T(n) ~ ", complexityClassName(estimate.best));
+    if (estimate.intercept > 0) {
+        length += std::snprintf(text + length, sizeof(text) - length, "%.3g ns + ", estimate.intercept * 1e9);
+    }
+    length += std::snprintf(text + length, sizeof(text) - length, "%.3g ns%s (fit error %.1f%%",
+                            estimate.constant * 1e9, terms[static_cast<int>(estimate.best)], estimate.error * 100);
+    if (estimate.fits.size() > 1) {
+        length += std::snprintf(text + length, sizeof(text) - length, ", next best %s %.1f%%",
+                                complexityClassName(estimate.fits[1].complexity), estimate.fits[1].error * 100);
+    }
+    std::snprintf(text + length, sizeof(text) - length, ")");
+    return text;
+}
+
+/*
+Time Complexity: the sum over the measured sizes of repetitions * (T(prepare) + T(run));
+with growth 2 the largest size dominates.
+Space Complexity: O(number of sizes) besides the inputs built by prepare.
+*/
+
+#endif